@@ -10,8 +10,8 @@ typedef enum
     /** App init done*/
     APP_INIT_DONE,
 
-    /** Sensor init done. Data is sensor_id_index */
-    SENSOR_VALUE_CHANGE,
+    /** Sensor values changed, one event per acquisition. Data is sensor_values_change */
+    SENSOR_VALUES_CHANGE,
 
     /** Config changed, no data */
     CONFIG_CHANGE,
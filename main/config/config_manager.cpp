@@ -17,6 +17,7 @@ constexpr std::string_view web_login_password_key{"web_password"};
 constexpr std::string_view ssid_key{"ssid"};
 constexpr std::string_view ssid_password_key{"ssid_password"};
 constexpr std::string_view screen_brightness_key{"scrn_brightness"};
+constexpr std::string_view sps30_sample_period_key{"sps30_period"};
 
 constexpr std::string_view default_host_name{"Air Quality Sensor"};
 constexpr std::string_view default_user_id_and_password{"admin"};
@@ -28,6 +29,7 @@ static const char SsidId[] = "ssid";
 static const char SsidPasswordId[] = "ssidpassword";
 static const char ScreenBrightnessId[] = "screenbrightness";
 static const char UsefahrenheitId[] = "usefahrenheit";
+static const char Sps30SamplePeriodId[] = "sps30sampleperiod";
 
 void config::begin()
 {
@@ -42,6 +44,7 @@ void config::begin()
     ESP_LOGI(CONFIG_TAG, "Wifi ssid password:%s", get_wifi_credentials().get_password().c_str());
     ESP_LOGI(CONFIG_TAG, "Manual screen brightness:%d", get_manual_screen_brightness().value_or(0));
     ESP_LOGI(CONFIG_TAG, "Use Fahrenheit:%s", is_use_fahrenheit() ? "Yes" : "No");
+    ESP_LOGI(CONFIG_TAG, "SPS30 sample period:%d", get_sps30_sample_period_seconds());
 }
 
 void config::save()
@@ -75,6 +78,7 @@ std::string config::get_all_config_as_json()
     }
 
     json_document[(UsefahrenheitId)] = is_use_fahrenheit();
+    json_document[(Sps30SamplePeriodId)] = get_sps30_sample_period_seconds();
 
     std::string json;
     serializeJson(json_document, json);
@@ -133,6 +137,18 @@ void config::set_manual_screen_brightness(const std::optional<uint8_t> &screen_b
     nvs_storage.save(screen_brightness_key, screen_brightness.value_or(0));
 }
 
+uint16_t config::get_sps30_sample_period_seconds()
+{
+    std::lock_guard<esp32::semaphore> lock(data_mutex_);
+    return nvs_storage.get(sps30_sample_period_key, static_cast<uint16_t>(0));
+}
+
+void config::set_sps30_sample_period_seconds(uint16_t sample_period_seconds)
+{
+    std::lock_guard<esp32::semaphore> lock(data_mutex_);
+    nvs_storage.save(sps30_sample_period_key, sample_period_seconds);
+}
+
 void config::set_wifi_credentials(const credentials &wifi_credentials)
 {
     std::lock_guard<esp32::semaphore> lock(data_mutex_);
@@ -31,6 +31,10 @@ class config : public esp32::singleton<config>
     std::optional<uint8_t> get_manual_screen_brightness();
     void set_manual_screen_brightness(const std::optional<uint8_t> &screen_brightness);
 
+    // 0 measures continuously
+    uint16_t get_sps30_sample_period_seconds();
+    void set_sps30_sample_period_seconds(uint16_t sample_period_seconds);
+
     void set_wifi_credentials(const credentials &wifi_credentials);
     credentials get_wifi_credentials();
 
@@ -35,6 +35,11 @@ void preferences::save(const std::string_view &key, uint8_t value)
     CHECK_THROW_ESP(nvs_set_u8(handle_, key.data(), value));
 }
 
+void preferences::save(const std::string_view &key, uint16_t value)
+{
+    CHECK_THROW_ESP(nvs_set_u16(handle_, key.data(), value));
+}
+
 bool preferences::get(const std::string_view &key, bool default_value)
 {
     const uint8_t value = get(key, static_cast<uint8_t>(default_value));
@@ -53,6 +58,18 @@ uint8_t preferences::get(const std::string_view &key, uint8_t default_value)
     return value;
 }
 
+uint16_t preferences::get(const std::string_view &key, uint16_t default_value)
+{
+    uint16_t value{};
+    const auto err = nvs_get_u16(handle_, key.data(), &value);
+    if (err == ESP_ERR_NVS_NOT_FOUND)
+    {
+        return default_value;
+    }
+    CHECK_THROW_ESP(err);
+    return value;
+}
+
 void preferences::save(const std::string_view &key, const std::string_view &value)
 {
     CHECK_THROW_ESP(nvs_set_str(handle_, key.data(), value.data()));
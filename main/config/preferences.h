@@ -21,12 +21,14 @@ class preferences : esp32::noncopyable
     void commit();
 
     void save(const std::string_view &key, uint8_t value);
+    void save(const std::string_view &key, uint16_t value);
     void save(const std::string_view &key, bool value);
     void save(const std::string_view &key, const std::string_view &value);
     void save(const std::string_view &key, const std::string &value);
 
     bool get(const std::string_view &key, bool default_value);
     uint8_t get(const std::string_view &key, uint8_t default_value);
+    uint16_t get(const std::string_view &key, uint16_t default_value);
     std::string get(const std::string_view &key, const std::string_view &default_value);
 
   private:
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "hardware/sensors/sensor_filter.h"
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Display brightness from ambient light. Lux is smoothed with an EMA and mapped on a log scale, 5 decades
+ * of lux over 0-255, through a table built at compile time. The brightness only follows once it would move by
+ * more than the hysteresis, so light close to a step does not flicker the backlight. Not thread safe.
+ */
+class auto_brightness
+{
+  public:
+    static constexpr uint8_t default_brightness = 128;
+
+    /**
+     * `time` is the esp32::millis() the lux was measured at
+     */
+    void add_lux(float lux, uint32_t time)
+    {
+        const auto level = lux_to_level(average_lux_(lux, time));
+        if (!brightness_.has_value() || (abs(level - brightness_.value()) > hysteresis_levels) || (level == 0) || (level == UINT8_MAX))
+        {
+            brightness_ = level;
+        }
+    }
+
+    uint8_t get_brightness() const
+    {
+        return brightness_.value_or(default_brightness);
+    }
+
+  private:
+    static constexpr uint8_t hysteresis_levels = 8; // about 40% change in lux
+
+    // thresholds[i] is the lowest lux for brightness i, 10^(i * 5 / 255)
+    static constexpr std::array<float, UINT8_MAX + 1> thresholds = [] {
+        std::array<float, UINT8_MAX + 1> values{};
+        double value = 1;
+        for (auto &&threshold : values)
+        {
+            threshold = value;
+            value *= 1.0461834443918254; // 10^(5 / 255)
+        }
+        return values;
+    }();
+
+    ema_filter<20, 1000> average_lux_; // weight of a value a second after the previous one, the usual read rate
+    std::optional<uint8_t> brightness_;
+
+    static uint8_t lux_to_level(float lux)
+    {
+        const auto next = std::upper_bound(thresholds.begin(), thresholds.end(), lux);
+        return next == thresholds.begin() ? 0 : (next - thresholds.begin() - 1);
+    }
+};
@@ -6,6 +6,7 @@
 #include "util/cores.h"
 #include "util/default_event.h"
 #include "util/exceptions.h"
+#include "util/misc.h"
 #include "wifi/wifi_manager.h"
 #include <esp_log.h>
 #include <lvgl.h>
@@ -138,14 +139,6 @@ void display::gui_task()
 
             if (result == pdPASS)
             {
-                if (notification_value & update_brightness_device_bit)
-                {
-                    const auto night_brightness = 50;
-                    ESP_LOGI(DISPLAY_TAG, "Setting display brightness to %d", current_brightness_);
-                    ui_instance_.set_day_or_night_theme(current_brightness_ <= night_brightness);
-                    display_device_.setBrightness(std::max<uint8_t>(10, current_brightness_));
-                }
-
                 if (notification_value & task_notify_wifi_changed_bit)
                 {
                     ui_instance_.wifi_changed();
@@ -177,6 +170,8 @@ void display::gui_task()
                     }
                 }
             }
+
+            ramp_brightness();
         } while (true);
     }
     catch (const std::exception &ex)
@@ -195,9 +190,10 @@ void display::app_event_handler(esp_event_base_t, int32_t event, void *data)
     case APP_INIT_DONE:
         xTaskNotify(lvgl_task_.handle(), set_main_screen_changed_bit, eSetBits);
         break;
-    case SENSOR_VALUE_CHANGE: {
-        const auto id = (*reinterpret_cast<sensor_id_index *>(data));
-        xTaskNotify(lvgl_task_.handle(), BIT(static_cast<uint8_t>(id) + 1), eSetBits);
+    case SENSOR_VALUES_CHANGE: {
+        // bit i + 1 is sensor i
+        const auto changed = reinterpret_cast<const sensor_values_change *>(data)->changed;
+        xTaskNotify(lvgl_task_.handle(), changed << 1, eSetBits);
     }
     break;
     case WIFI_STATUS_CHANGED:
@@ -216,9 +212,39 @@ void display::app_event_handler(esp_event_base_t, int32_t event, void *data)
 }
 void display::set_screen_brightness(uint8_t value)
 {
-    if (current_brightness_ != value)
+    // picked up by the display task on its next loop
+    target_brightness_ = value;
+}
+
+void display::ramp_brightness()
+{
+    const uint8_t target = target_brightness_;
+    if (current_brightness_ == target)
+    {
+        return;
+    }
+
+    const auto now = esp32::millis();
+    if (now - last_brightness_step_ < brightness_ramp_interval_ms)
+    {
+        return;
+    }
+    last_brightness_step_ = now;
+
+    // theme follows the target, so it does not flip while ramping through the threshold
+    const bool night_theme = target <= night_brightness;
+    if (night_theme_ != night_theme)
+    {
+        ui_instance_.set_day_or_night_theme(night_theme);
+        night_theme_ = night_theme;
+    }
+
+    current_brightness_ = (current_brightness_ < target) ? std::min<int>(current_brightness_ + brightness_ramp_step, target)
+                                                         : std::max<int>(current_brightness_ - brightness_ramp_step, target);
+    display_device_.setBrightness(std::max(min_brightness, current_brightness_));
+
+    if (current_brightness_ == target)
     {
-        current_brightness_ = value;
-        xTaskNotify(lvgl_task_.handle(), update_brightness_device_bit, eSetBits);
+        ESP_LOGI(DISPLAY_TAG, "Display brightness set to %d", current_brightness_);
     }
 }
@@ -8,7 +8,9 @@
 #include "util/semaphore_lockable.h"
 #include "util/singleton.h"
 #include "util/task_wrapper.h"
+#include <atomic>
 #include <lvgl.h>
+#include <optional>
 
 class display final : public esp32::singleton<display>
 {
@@ -29,7 +31,14 @@ class display final : public esp32::singleton<display>
     LGFX display_device_;
     esp32::task lvgl_task_;
     ui_interface &ui_interface_;
-    uint8_t current_brightness_{128};
+
+    // set by any task, the display task ramps the backlight to it
+    std::atomic_uint8_t target_brightness_{128};
+
+    // only used by the display task
+    uint8_t current_brightness_{0};
+    uint32_t last_brightness_step_{0};
+    std::optional<bool> night_theme_;
 
     lv_disp_draw_buf_t draw_buf_{};
     lv_disp_drv_t disp_drv_{};
@@ -45,11 +54,16 @@ class display final : public esp32::singleton<display>
     static void IRAM_ATTR touchpad_read(lv_indev_drv_t *indev_driver, lv_indev_data_t *data);
     void gui_task();
     void app_event_handler(esp_event_base_t, int32_t, void *);
+    void ramp_brightness();
+
+    constexpr static uint8_t night_brightness = 50;
+    constexpr static uint8_t min_brightness = 10;
+    constexpr static uint8_t brightness_ramp_step = 2;
+    constexpr static uint32_t brightness_ramp_interval_ms = 20; // full range in ~2.5s
 
     constexpr static uint32_t task_notify_wifi_changed_bit = BIT(total_sensors + 1);
     constexpr static uint32_t set_main_screen_changed_bit = BIT(total_sensors + 2);
     constexpr static uint32_t task_notify_restarting_bit = BIT(total_sensors + 3);
     constexpr static uint32_t config_changed_bit = BIT(total_sensors + 4);
     constexpr static uint32_t idenitfy_device_bit = BIT(total_sensors + 5);
-    constexpr static uint32_t update_brightness_device_bit = BIT(total_sensors + 6);
 };
\ No newline at end of file
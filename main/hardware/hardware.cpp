@@ -9,21 +9,171 @@
 #include "util/cores.h"
 #include "util/exceptions.h"
 #include "util/helper.h"
+#include "util/metrics.h"
 #include "util/misc.h"
 #include <driver/i2c.h>
 #include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 
-template <class T> void hardware::read_sensor_if_time(T &sensor, uint64_t &last_read)
+template <class T> TickType_t hardware::init_sensor(T &sensor)
 {
-    const auto now = esp32::millis();
-    if (now - last_read >= sensor_history::sensor_interval)
+    if (!i2c_bus_.execute([&sensor] { sensor.init(); }, sensor_init_timeout).has_value())
+    {
+        CHECK_THROW_ESP2(ESP_ERR_TIMEOUT, "Sensor init timed out");
+    }
+
+    if constexpr (requires { sensor.get_initial_delay(); })
+    {
+        return sensor.get_initial_delay();
+    }
+    return 0;
+}
+
+template <class T> void hardware::start_read(T &sensor, pending_read<T> &pending, sensor_device device, uint32_t deadline)
+{
+    if (pending.valid())
     {
-        for (auto &&value : sensor.read())
+        // due again as the stall check, rescheduled once the read is done
+        if (pending.running() && sensor.get_stats().is_healthy())
         {
-            set_sensor_value(std::get<0>(value), std::get<1>(value));
+            ESP_LOGW(HARDWARE_TAG, "Read of %s is stalled, reading the other devices without it", sensor.get_stats().get_name());
+            sensor.get_stats().record_stall();
         }
-        last_read = now;
+        sensor_scheduler_.schedule(device, esp32::millis() + sensor_stall_timeout);
+        return;
+    }
+
+    prepare_read(sensor);
+    pending = i2c_bus_.submit(
+        [sensor = &sensor] {
+            const auto start = esp_timer_get_time();
+            auto reading = sensor->read();
+
+            uint8_t nan_values = 0;
+            if (reading.has_value())
+            {
+                for (auto &&value : reading->values)
+                {
+                    nan_values += std::isnan(std::get<1>(value));
+                }
+            }
+            sensor->get_stats().record_read(esp_timer_get_time() - start, reading.has_value(), nan_values);
+            return reading;
+        },
+        sensor_read_timeout);
+
+    if (!pending.valid())
+    {
+        // no free slot on the bus, retried like a device without new data
+        sensor.get_stats().record_timeout();
+        schedule_next(device, deadline, data_ready_poll_interval);
+        return;
+    }
+
+    read_deadlines_[device] = deadline;
+    sensor_scheduler_.schedule(device, esp32::millis() + sensor_stall_timeout);
+}
+
+template <class T> void hardware::complete_read(T &sensor, pending_read<T> &pending, sensor_device device)
+{
+    if (!pending.ready())
+    {
+        return;
     }
+
+    const auto result = pending.get();
+    if (!sensor.get_stats().is_healthy())
+    {
+        ESP_LOGI(HARDWARE_TAG, "Stalled read of %s is done", sensor.get_stats().get_name());
+        sensor.get_stats().record_recovery();
+    }
+    if (!result.has_value())
+    {
+        // not started in time, retried like a device without new data
+        sensor.get_stats().record_timeout();
+    }
+
+    sensor_scheduler_.cancel(device); // the stall check
+    schedule_next(device, read_deadlines_[device], read_device(sensor, device, result.value_or(std::nullopt)));
+    post_sensor_changes();
+}
+
+template <class T> uint32_t hardware::read_sensor(T &sensor, sensor_device device, const decltype(sensor.read()) &reading)
+{
+    if (!reading.has_value())
+    {
+        // devices which know when their next measurement is ready are not polled before
+        if constexpr (requires { sensor.get_time_to_next_measurement(); })
+        {
+            return std::max(data_ready_poll_interval, sensor.get_time_to_next_measurement());
+        }
+        return data_ready_poll_interval;
+    }
+
+    bool changed = false;
+    for (auto &&value : reading->values)
+    {
+        const auto index = std::get<0>(value);
+        const auto previous = get_sensor_value(index);
+        set_sensor_value(index, std::get<1>(value), reading->time);
+        sample_holds_[static_cast<size_t>(index)] = reading->hold_ms;
+
+        const auto current = get_sensor_value(index);
+        if (std::isnan(previous) || std::isnan(current))
+        {
+            changed |= std::isnan(previous) != std::isnan(current);
+        }
+        else
+        {
+            changed |= get_sensor_definition(index).exceeds_notify_deadband(previous, current);
+        }
+    }
+
+    // a duty cycled device is read at its own deadlines, a longer interval would keep it on for longer
+    if constexpr (requires { sensor.is_duty_cycled(); })
+    {
+        if (sensor.is_duty_cycled())
+        {
+            return sensor.get_time_to_next_measurement();
+        }
+    }
+
+    // the next measurement is not ready before T::measurement_interval_ms
+    constexpr auto fast = std::max<uint32_t>(T::measurement_interval_ms, fast_read_interval);
+    constexpr auto slow = std::max<uint32_t>(fast, slow_read_interval);
+    return read_intervals_[device].next(changed, fast, slow);
+}
+
+void hardware::collect(esp32::metrics::writer &writer) const
+{
+    using esp32::metrics::metric_type;
+
+    writer.family("sensor_read_duration_seconds", "Time to read a sensor device on the i2c bus", metric_type::histogram);
+    for_each_device_stats([&writer](const sensor_device_stats &stats) {
+        writer.histogram("sensor_read_duration_seconds", {{"device", stats.get_name()}}, stats.get_read_latency(), 1e-6);
+    });
+
+    writer.family("sensor_read_errors_total", "Failed reads of a sensor device", metric_type::counter);
+    for_each_device_stats([&writer](const sensor_device_stats &stats) {
+        writer.sample("sensor_read_errors_total", {{"device", stats.get_name()}}, static_cast<uint64_t>(stats.get_errors()));
+    });
+
+    writer.family("sensor_read_timeouts_total", "Reads of a sensor device which timed out on the i2c bus", metric_type::counter);
+    for_each_device_stats([&writer](const sensor_device_stats &stats) {
+        writer.sample("sensor_read_timeouts_total", {{"device", stats.get_name()}}, static_cast<uint64_t>(stats.get_timeouts()));
+    });
+
+    writer.family("sensor_read_stalls_total", "Reads of a sensor device still running on the i2c bus when the next one was due",
+                  metric_type::counter);
+    for_each_device_stats([&writer](const sensor_device_stats &stats) {
+        writer.sample("sensor_read_stalls_total", {{"device", stats.get_name()}}, static_cast<uint64_t>(stats.get_stalls()));
+    });
+
+    writer.family("sensor_healthy", "1 if reads of a sensor device finish in time", metric_type::gauge);
+    for_each_device_stats([&writer](const sensor_device_stats &stats) {
+        writer.sample("sensor_healthy", {{"device", stats.get_name()}}, static_cast<uint64_t>(stats.is_healthy()));
+    });
 }
 
 float hardware::get_sensor_value(sensor_id_index index) const
@@ -32,50 +182,102 @@ float hardware::get_sensor_value(sensor_id_index index) const
     return sensor.get_value();
 }
 
-sensor_history::sensor_history_snapshot hardware::get_sensor_detail_info(sensor_id_index index)
+sensor_history::snapshot_handle hardware::get_sensor_detail_info(sensor_id_index index, uint32_t range_seconds, uint16_t max_points)
 {
-    return (*sensors_history_)[static_cast<size_t>(index)].get_snapshot(sensor_history::reads_per_minute);
+    return (*sensors_history_)[static_cast<size_t>(index)].get_shared_snapshot(range_seconds, max_points);
 }
 
 bool hardware::clean_sps_30()
 {
-    return sps30_sensor_.clean();
+    auto sensor = find_device<sps30_sensor_device>();
+    if (!sensor)
+    {
+        return false;
+    }
+    return i2c_bus_.execute([sensor] { return sensor->clean(); }, sensor_command_timeout).value_or(false);
 }
 
 #ifdef CONFIG_SCD4x_SENSOR_ENABLE
 bool hardware::factory_reset_scd4x()
 {
-    return scd4x_sensor_.factory_reset();
+    auto sensor = find_device<scd4x_sensor_device>();
+    return i2c_bus_.execute([sensor] { return sensor->factory_reset(); }, sensor_init_timeout).value_or(false);
 }
 #endif
 
 void hardware::begin()
 {
+    for (auto i = 0; i < total_sensors; i++)
+    {
+        const auto id = static_cast<sensor_id_index>(i);
+        (*sensors_history_)[i].set_value_step(get_sensor_definition(id).get_value_step());
+    }
+
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+    history_store_.restore();
+    history_store_.begin();
+    CHECK_THROW_ESP(esp_register_shutdown_handler(hardware_shutdown_handler));
+#endif
+
     CHECK_THROW_ESP(i2cdev_init());
+    i2c_bus_.begin("i2c_bus", esp32::task::default_priority, esp32::hardware_core);
     sensor_refresh_task_.spawn_pinned("sensor_task", 4 * 1024, esp32::task::default_priority, esp32::hardware_core);
 }
 
-void hardware::set_sensor_value(sensor_id_index index, float value)
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+void hardware::hardware_shutdown_handler()
+{
+    try
+    {
+        hardware::get_instance().history_store_.flush();
+    }
+    catch (const std::exception &ex)
+    {
+        ESP_LOGE(HARDWARE_TAG, "Failed to flush sensor history with :%s", ex.what());
+    }
+}
+#endif
+
+void hardware::set_sensor_value(sensor_id_index index, float value, uint32_t time)
 {
-    bool changed;
+    value = sensor_filters_.apply(index, value, time);
+
+    sensor_value_change change;
     const auto i = static_cast<size_t>(index);
+    const auto &definition = get_sensor_definition(index);
     if (!std::isnan(value))
     {
-        (*sensors_history_)[i].add_value(value);
-        changed = sensors_[i].set_value(value);
+        change = sensors_[i].set_value(value, definition, time);
         ESP_LOGI(HARDWARE_TAG, "Updated for sensor:%.*s Value:%g", get_sensor_name(index).size(), get_sensor_name(index).data(),
                  sensors_[i].get_value());
     }
     else
     {
         ESP_LOGW(HARDWARE_TAG, "Got an invalid value for sensor:%.*s", get_sensor_name(index).size(), get_sensor_name(index).data());
-        (*sensors_history_)[i].clear();
-        changed = sensors_[i].set_invalid_value();
+        change = sensors_[i].set_invalid_value(definition, time);
+    }
+    sample_times_[i] = time;
+
+    // history has every value, listeners are only told about significant changes
+    if (change == sensor_value_change::notify)
+    {
+        sensor_changes_notified_++;
+        pending_changes_.set(index, sensors_[i].get_value());
     }
+    else if (change == sensor_value_change::suppressed)
+    {
+        sensor_changes_suppressed_++;
+    }
+}
 
-    if (changed)
+void hardware::post_sensor_changes()
+{
+    // one event for all values of a read, instead of one per sensor
+    if (pending_changes_.changed)
     {
-        CHECK_THROW_ESP(esp32::event_post(APP_COMMON_EVENT, SENSOR_VALUE_CHANGE, index));
+        sensor_events_posted_++;
+        CHECK_THROW_ESP(esp32::event_post(APP_COMMON_EVENT, SENSOR_VALUES_CHANGE, pending_changes_));
+        pending_changes_ = {};
     }
 }
 
@@ -86,47 +288,44 @@ void hardware::sensor_task_ftn()
         ESP_LOGI(HARDWARE_TAG, "Sensor task started on core:%d", xPortGetCoreID());
 
         TickType_t initial_delay = 0;
-
-        sps30_sensor_.init();
-        bh1750_sensor_.init();
-        initial_delay = std::max(initial_delay, bh1750_sensor_.get_initial_delay());
-
-#ifdef CONFIG_SHT3X_SENSOR_ENABLE
-        sht3x_sensor_.init();
-        initial_delay = std::max<TickType_t>(initial_delay, sht3x_sensor_.get_initial_delay());
-#endif
-
-#ifdef CONFIG_SCD30_SENSOR_ENABLE
-        scd30_sensor_.init();
-        initial_delay = std::max<TickType_t>(initial_delay, scd30_sensor_.get_initial_delay());
-#endif
-
-#ifdef CONFIG_SCD4x_SENSOR_ENABLE
-        scd4x_sensor_.init();
-        initial_delay = std::max<TickType_t>(initial_delay, scd4x_sensor_.get_initial_delay());
-#endif
+        std::apply([this, &initial_delay](auto &...devices) { ((initial_delay = std::max(initial_delay, init_sensor(devices))), ...); },
+                   devices_);
 
         // Wait until all sensors_ are ready
         vTaskDelay(initial_delay);
 
-        do
+        const auto start = esp32::millis();
+        for (sensor_device device = 0; device < history_device; device++)
         {
-            read_bh1750_sensor();
-            set_auto_display_brightness();
-#ifdef CONFIG_SCD30_SENSOR_ENABLE
-            read_scd30_sensor();
-#endif
-
-#ifdef CONFIG_SCD4x_SENSOR_ENABLE
-            read_scd4x_sensor();
-#endif
-
-#ifdef CONFIG_SHT3X_SENSOR_ENABLE
-            read_sht3x_sensor();
-#endif
-            read_sps30_sensor();
+            sensor_scheduler_.schedule(device, start);
+        }
+        sensor_scheduler_.schedule(history_device, start + sensor_history::sensor_interval);
 
-            vTaskDelay(pdMS_TO_TICKS(sensor_history::sensor_interval / 10));
+        do
+        {
+            complete_device_reads();
+
+            const auto now = esp32::millis();
+            const auto due = sensor_scheduler_.pop_due(now);
+            if (!due.has_value())
+            {
+                // sleep until the next deadline or until the bus is done with a read, rounded up to a tick
+                const auto wait_ms = sensor_scheduler_.time_to_next(now).value();
+                ulTaskNotifyTake(pdTRUE, std::max<TickType_t>(1, (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS));
+                continue;
+            }
+
+            const auto [device, deadline] = due.value();
+            if (device == history_device)
+            {
+                update_history();
+                post_sensor_changes();
+                schedule_next(device, deadline, sensor_history::sensor_interval);
+            }
+            else
+            {
+                start_device_read(device, deadline);
+            }
         } while (true);
     }
     catch (const std::exception &ex)
@@ -138,65 +337,94 @@ void hardware::sensor_task_ftn()
     vTaskDelete(NULL);
 }
 
-void hardware::read_bh1750_sensor()
+void hardware::start_device_read(sensor_device device, uint32_t deadline)
 {
-    const auto values = bh1750_sensor_.read();
-
-    if (!std::isnan(std::get<1>(values[0])))
-    {
-        light_sensor_values_.add_value(std::get<1>(values[0]));
-    }
-
-    const auto now = esp32::millis();
-    if (now - bh1750_sensor_last_read_ >= sensor_history::sensor_interval)
-    {
-        for (auto &&value : values)
+    for_each_device([this, device, deadline](auto &sensor, auto &pending, sensor_device index) {
+        if (index == device)
         {
-            set_sensor_value(std::get<0>(value), std::get<1>(value));
+            start_read(sensor, pending, device, deadline);
         }
-
-        bh1750_sensor_last_read_ = now;
-    }
+    });
 }
 
-#ifdef CONFIG_SHT3X_SENSOR_ENABLE
-void hardware::read_sht3x_sensor()
+void hardware::complete_device_reads()
 {
-    read_sensor_if_time(sht3x_sensor_, sht3x_sensor_last_read_);
+    for_each_device([this](auto &sensor, auto &pending, sensor_device index) { complete_read(sensor, pending, index); });
 }
-#endif
 
-#ifdef CONFIG_SCD30_SENSOR_ENABLE
-void hardware::read_scd30_sensor()
+void hardware::schedule_next(sensor_device device, uint32_t deadline, uint32_t interval)
 {
-    read_sensor_if_time(scd30_sensor_, scd30_sensor_last_read_);
+    const uint32_t next = deadline + interval;
+    const uint32_t now = esp32::millis();
+    sensor_scheduler_.schedule(device, static_cast<int32_t>(next - now) > 0 ? next : now + interval);
 }
-#endif
 
-#ifdef CONFIG_SCD4x_SENSOR_ENABLE
-void hardware::read_scd4x_sensor()
+void hardware::prepare_read(sps30_sensor_device &sensor)
 {
-    read_sensor_if_time(scd4x_sensor_, scd4x_sensor_last_read_);
+    sensor.set_sample_period_ms(config_.get_sps30_sample_period_seconds() * 1000);
 }
-#endif
 
-void hardware::read_sps30_sensor()
+void hardware::update_history()
 {
-    read_sensor_if_time(sps30_sensor_, sps30_sensor_last_read_);
+    const auto now = esp32::millis();
+    for (auto i = 0; i < total_sensors; i++)
+    {
+        const auto index = static_cast<sensor_id_index>(i);
+        auto value = sensors_[i].get_value();
+
+        if (!std::isnan(value) && (now - sample_times_[i] > max_sample_age + sample_holds_[i]))
+        {
+            ESP_LOGW(HARDWARE_TAG, "No new value for sensor:%.*s", get_sensor_name(index).size(), get_sensor_name(index).data());
+            set_sensor_value(index, NAN, now);
+            value = NAN;
+        }
+
+        if (!std::isnan(value))
+        {
+            // the history is written every interval so that snapshots are current, the store batches runs for the sd card
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+            history_store_.add_value(index, value);
+#else
+            (*sensors_history_)[i].add_value(value);
+#endif
+            history_has_values_.set(i);
+        }
+        else if (history_has_values_.test(i))
+        {
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+            history_store_.clear(index);
+#else
+            (*sensors_history_)[i].clear();
+#endif
+            history_has_values_.reset(i);
+        }
+    }
 }
 
-uint8_t hardware::lux_to_intensity(uint16_t lux)
+uint32_t hardware::read_device(bh1750_sensor_device &sensor, sensor_device, const optional_sensor_reading<1> &reading)
 {
-    if (lux != 0)
+    if (reading.has_value())
     {
-        // https://learn.microsoft.com/en-us/windows/win32/sensorsapi/understanding-and-interpreting-lux-values
-        const auto intensity = (std::log10(lux) / 5) * 255;
-        return intensity;
-    }
-    else
-    {
-        return 0;
+        const auto lux = std::get<1>(reading->values[0]);
+        if (!std::isnan(lux))
+        {
+            auto_brightness_.add_lux(lux, reading->time);
+        }
+
+        // brightness needs frequent reads, the value itself only changes every sensor_interval
+        if (reading->time - bh1750_sensor_last_published_ >= sensor_history::sensor_interval)
+        {
+            for (auto &&value : reading->values)
+            {
+                set_sensor_value(std::get<0>(value), std::get<1>(value), reading->time);
+            }
+
+            bh1750_sensor_last_published_ = reading->time;
+        }
     }
+
+    set_auto_display_brightness();
+    return bh1750_read_interval;
 }
 
 void hardware::set_auto_display_brightness()
@@ -211,9 +439,7 @@ void hardware::set_auto_display_brightness()
     }
     else
     {
-        const auto avg_lux = light_sensor_values_.get_average();
-        ESP_LOGD(SENSOR_BH1750_TAG, "Average lux:%g", avg_lux.value_or(128));
-        required_brightness = lux_to_intensity(avg_lux.value_or(128));
+        required_brightness = auto_brightness_.get_brightness();
     }
 
     ESP_LOGD(SENSOR_BH1750_TAG, "Required brightness:%d", required_brightness);
@@ -222,5 +448,22 @@ void hardware::set_auto_display_brightness()
 
 std::string hardware::get_sps30_error_register_status()
 {
-    return sps30_sensor_.get_error_register_status();
+    auto sensor = find_device<sps30_sensor_device>();
+    if (!sensor)
+    {
+        return "Not present";
+    }
+    return i2c_bus_.execute([sensor] { return sensor->get_error_register_status(); }, sensor_command_timeout).value_or("Timed out");
+}
+
+std::string hardware::get_sps30_duty_cycle_status() const
+{
+    const auto sensor = find_device<sps30_sensor_device>();
+    return sensor ? sensor->get_duty_cycle_status() : "Not present";
+}
+
+std::string hardware::get_sensor_events_status() const
+{
+    return esp32::string::sprintf("Notified:%lu Suppressed:%lu Events:%lu", sensor_changes_notified_.load(), sensor_changes_suppressed_.load(),
+                                  sensor_events_posted_.load());
 }
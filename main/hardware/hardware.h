@@ -1,20 +1,29 @@
 #pragma once
 
-#include "hardware/sensors/bh1750_sensor_device.h"
-#include "hardware/sensors/scd30_sensor_device.h"
-#include "hardware/sensors/scd4x_sensor_device.h"
+#include "hardware/display/auto_brightness.h"
+#include "hardware/i2c_bus_worker.h"
+#include "hardware/sensor_history_store.h"
+#include "hardware/sensors/adaptive_read_interval.h"
 #include "hardware/sensors/sensor.h"
-#include "hardware/sensors/sht3x_sensor_device.h"
-#include "hardware/sensors/sps30_sensor_device.h"
+#include "hardware/sensors/sensor_device_registry.h"
+#include "hardware/sensors/sensor_filter.h"
 #include "ui/ui_interface.h"
+#include "util/deadline_scheduler.h"
+#include "util/metrics.h"
 #include "util/psram_allocator.h"
 #include "util/singleton.h"
+#include <atomic>
+#include <bitset>
 #include <i2cdev.h>
+#include <utility>
 
 class display;
 class config;
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+class sd_card;
+#endif
 
-class hardware final : public esp32::singleton<hardware>
+class hardware final : public esp32::singleton<hardware>, protected esp32::metrics::collector
 {
   public:
     void begin();
@@ -25,7 +34,8 @@ class hardware final : public esp32::singleton<hardware>
     }
 
     float get_sensor_value(sensor_id_index index) const;
-    sensor_history::sensor_history_snapshot get_sensor_detail_info(sensor_id_index index);
+    sensor_history::snapshot_handle get_sensor_detail_info(sensor_id_index index, uint32_t range_seconds = sensor_history::default_range_seconds,
+                                                           uint16_t max_points = sensor_history::default_max_points);
 
     const sensor_history &get_sensor_history(sensor_id_index index) const
     {
@@ -33,16 +43,33 @@ class hardware final : public esp32::singleton<hardware>
     }
 
     std::string get_sps30_error_register_status();
+    std::string get_sps30_duty_cycle_status() const;
+    std::string get_sensor_events_status() const;
     bool clean_sps_30();
 
+    /**
+     * Calls `ftn` with the stats of every device in sensor_devices, from any task
+     */
+    template <class F> void for_each_device_stats(F &&ftn) const
+    {
+        std::apply([&ftn](auto &...devices) { (ftn(static_cast<const sensor_device_stats &>(devices.get_stats())), ...); }, devices_);
+    }
+
 #ifdef CONFIG_SCD4x_SENSOR_ENABLE
     bool factory_reset_scd4x();
 #endif
 
   private:
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+    hardware(config &config, display &display, sd_card &sd_card)
+        : config_(config), display_(display), history_store_(sd_card, *sensors_history_), sensor_refresh_task_([this] { sensor_task_ftn(); })
+    {
+    }
+#else
     hardware(config &config, display &display) : config_(config), display_(display), sensor_refresh_task_([this] { sensor_task_ftn(); })
     {
     }
+#endif
 
     friend class esp32::singleton<hardware>;
 
@@ -51,58 +78,139 @@ class hardware final : public esp32::singleton<hardware>
 
     // same index as sensor_id_index
     std::array<sensor_value, total_sensors> sensors_;
+    sensor_filters sensor_filters_; // only used from the sensor task
+    std::array<uint32_t, total_sensors> sample_times_{}; // when the current values were measured
+    std::array<uint32_t, total_sensors> sample_holds_{}; // sensor_reading::hold_ms of the current values
+    std::bitset<total_sensors> history_has_values_;      // history is cleared once when a sensor becomes invalid
+
+    sensor_values_change pending_changes_; // posted once the current device read is done
+    std::atomic_uint32_t sensor_changes_notified_{0};
+    std::atomic_uint32_t sensor_changes_suppressed_{0};
+    std::atomic_uint32_t sensor_events_posted_{0};
     std::unique_ptr<std::array<sensor_history, total_sensors>, esp32::psram::deleter> sensors_history_ =
         esp32::psram::make_unique<std::array<sensor_history, total_sensors>>();
 
-    esp32::task sensor_refresh_task_;
-
-    using light_sensor_values_t = sensor_history_t<12>;
-    light_sensor_values_t light_sensor_values_;
-
-#ifdef CONFIG_SHT3X_SENSOR_ENABLE
-    // SHT31
-    sht3x_sensor_device &sht3x_sensor_{sht3x_sensor_device::create_instance()};
-    uint64_t sht3x_sensor_last_read_ = 0;
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+    sensor_history_store history_store_;
+    static void hardware_shutdown_handler();
 #endif
 
-#ifdef CONFIG_SCD30_SENSOR_ENABLE
-    // SCD30
-    scd30_sensor_device &scd30_sensor_{scd30_sensor_device::create_instance()};
-    uint64_t scd30_sensor_last_read_ = 0;
-#endif
+    esp32::task sensor_refresh_task_;
 
-#ifdef CONFIG_SCD4x_SENSOR_ENABLE
-    // SCD4x
-    scd4x_sensor_device &scd4x_sensor_{scd4x_sensor_device::create_instance()};
-    uint64_t scd4x_sensor_last_read_ = 0;
-#endif
+    auto_brightness auto_brightness_;
 
-    // SPS 30
-    sps30_sensor_device &sps30_sensor_{sps30_sensor_device::create_instance()};
-    uint64_t sps30_sensor_last_read_ = 0;
+    // index in sensor_devices, the entry after the devices appends the current values to history
+    using sensor_device = uint8_t;
+    static constexpr sensor_device history_device = sensor_devices::size;
 
-    // BH1750
-    bh1750_sensor_device &bh1750_sensor_{bh1750_sensor_device::create_instance()};
-    uint64_t bh1750_sensor_last_read_ = 0;
+    static constexpr uint32_t bh1750_read_interval = 1000; // for display brightness
+    static constexpr uint32_t data_ready_poll_interval = 1000;
+    // values older than this are invalid, twice the slowest device interval
+    static constexpr uint32_t max_sample_age = 2 * 30 * 1000 + sensor_history::sensor_interval;
 
-    void set_sensor_value(sensor_id_index index, float value);
+    esp32::deadline_scheduler<sensor_device, sensor_devices::size + 1> sensor_scheduler_;
 
-    void read_bh1750_sensor();
-#ifdef CONFIG_SHT3X_SENSOR_ENABLE
-    void read_sht3x_sensor();
-#endif
-#ifdef CONFIG_SCD30_SENSOR_ENABLE
-    void read_scd30_sensor();
+    // devices measuring slower than the fast interval are read at their own rate
+#ifdef CONFIG_SENSOR_ADAPTIVE_SAMPLING
+    static constexpr uint32_t fast_read_interval = 1000;
+    static constexpr uint32_t slow_read_interval = 30 * 1000;
+#else
+    static constexpr uint32_t fast_read_interval = sensor_history::sensor_interval;
+    static constexpr uint32_t slow_read_interval = sensor_history::sensor_interval;
 #endif
-#ifdef CONFIG_SCD4x_SENSOR_ENABLE
-    void read_scd4x_sensor();
-#endif
-    esp_err_t sps30_i2c_init();
-    void read_sps30_sensor();
-    uint8_t lux_to_intensity(uint16_t lux);
+    static_assert(slow_read_interval < max_sample_age);
+    std::array<adaptive_read_interval, sensor_devices::size> read_intervals_;
+
+    // all sensors are on I2C_NUM_1, every device call runs on its worker
+    i2c_bus_worker i2c_bus_;
+    static constexpr TickType_t sensor_read_timeout = pdMS_TO_TICKS(2000); // to start a read
+    static constexpr uint32_t sensor_stall_timeout = 10 * 1000;            // a read running longer marks its device unhealthy
+    static constexpr TickType_t sensor_command_timeout = pdMS_TO_TICKS(5000);
+    static constexpr TickType_t sensor_init_timeout = pdMS_TO_TICKS(30000); // SCD4x self test takes 10 seconds
+
+    sensor_devices::references devices_{sensor_devices::create_instances()};
+
+    // at most one read of each device is on the bus, the sensor task goes on with the other devices meanwhile
+    template <class T> using pending_read = i2c_bus_worker::future<decltype(std::declval<T &>().read())>;
+    sensor_devices::transform<pending_read> pending_reads_;
+    std::array<uint32_t, sensor_devices::size> read_deadlines_{}; // deadline the pending read was started for
+    uint32_t bh1750_sensor_last_published_ = 0;
+
+    void set_sensor_value(sensor_id_index index, float value, uint32_t time);
+    void post_sensor_changes();
+
+    /**
+     * Devices measure at their own rate, history needs a value every sensor_interval. The last value of each
+     * sensor is held until it is older than max_sample_age plus its hold time, then the sensor becomes invalid.
+     */
+    void update_history();
+
+    /**
+     * Queues a read of the device, or checks on its read in flight if that is still not done
+     */
+    void start_device_read(sensor_device device, uint32_t deadline);
+
+    /**
+     * Handles the reads which are done and schedules the next read of their devices
+     */
+    void complete_device_reads();
+
+    // schedules the device `interval` after `deadline`, keeping the cadence unless that has already passed
+    void schedule_next(sensor_device device, uint32_t deadline, uint32_t interval);
+
+    /**
+     * Calls `ftn(device, pending read, index in sensor_devices)` for every device
+     */
+    template <class F> void for_each_device(F &&ftn)
+    {
+        [this, &ftn]<size_t... I>(std::index_sequence<I...>) {
+            (ftn(std::get<I>(devices_), std::get<I>(pending_reads_), static_cast<sensor_device>(I)), ...);
+        }(std::make_index_sequence<sensor_devices::size>());
+    }
+
+    /**
+     * Runs on the sensor task before a read is queued
+     */
+    void prepare_read(sps30_sensor_device &sensor);
+    template <class T> void prepare_read(T &)
+    {
+    }
+
+    /**
+     * Handles a reading of the device, returns the milliseconds until it should be read again
+     */
+    uint32_t read_device(bh1750_sensor_device &sensor, sensor_device device, const optional_sensor_reading<1> &reading);
+    template <class T, class R> uint32_t read_device(T &sensor, sensor_device device, const R &reading)
+    {
+        return read_sensor(sensor, device, reading);
+    }
     void set_auto_display_brightness();
 
     void sensor_task_ftn();
 
-    template <class T> void read_sensor_if_time(T &sensor, uint64_t &last_read);
+    // acquisition metrics of the devices, from the counters sensor_device_stats keeps anyway
+    void collect(esp32::metrics::writer &writer) const override;
+
+    /**
+     * Device if it is in sensor_devices, otherwise nullptr
+     */
+    template <class T> T *find_device() const
+    {
+        if constexpr (sensor_devices::contains<T>)
+        {
+            return &std::get<T &>(devices_);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    /**
+     * Initializes the device, returns the delay before its first read
+     */
+    template <class T> TickType_t init_sensor(T &sensor);
+    template <class T> void start_read(T &sensor, pending_read<T> &pending, sensor_device device, uint32_t deadline);
+    template <class T> void complete_read(T &sensor, pending_read<T> &pending, sensor_device device);
+    template <class T> uint32_t read_sensor(T &sensor, sensor_device device, const decltype(sensor.read()) &reading);
 };
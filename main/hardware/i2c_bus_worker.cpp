@@ -0,0 +1,74 @@
+#include "hardware/i2c_bus_worker.h"
+#include "logging/logging_tags.h"
+#include "util/exceptions.h"
+#include <esp_log.h>
+
+i2c_bus_worker::i2c_bus_worker() : worker_task_([this] { worker_task_ftn(); })
+{
+    for (auto &&current : slots_)
+    {
+        current.done = xSemaphoreCreateBinaryStatic(&current.done_buffer);
+        configASSERT(current.done);
+        free_slots_.enqueue(&current, 0);
+    }
+}
+
+void i2c_bus_worker::begin(const char *name, uint32_t priority, BaseType_t core)
+{
+    CHECK_THROW_ESP(worker_task_.spawn_pinned(name, 4 * 1024, priority, core));
+}
+
+void i2c_bus_worker::worker_task_ftn()
+{
+    while (true)
+    {
+        slot *current;
+        if (!queue_.dequeue(current, portMAX_DELAY))
+        {
+            continue;
+        }
+
+        do
+        {
+            run(*current);
+        } while (queue_.dequeue(current, 0));
+    }
+
+    vTaskDelete(NULL);
+}
+
+void i2c_bus_worker::run(slot &current)
+{
+    // the caller can take the result and reuse the slot as soon as it is done
+    const auto notify = current.notify;
+    auto expected = slot_state::queued;
+
+    if (static_cast<int32_t>(xTaskGetTickCount() - current.deadline) > 0)
+    {
+        ESP_LOGW(HARDWARE_TAG, "I2C transaction dropped as it was not started in time");
+    }
+    else if (current.state.compare_exchange_strong(expected, slot_state::running, std::memory_order_acq_rel))
+    {
+        current.handler(current, true);
+        expected = slot_state::running;
+    }
+
+    // done without a result if it was not run, unless the caller gave up on it
+    if ((expected == slot_state::abandoned) || !current.state.compare_exchange_strong(expected, slot_state::done, std::memory_order_acq_rel))
+    {
+        release(current);
+        return;
+    }
+
+    xSemaphoreGive(current.done);
+    if (notify)
+    {
+        xTaskNotifyGive(notify);
+    }
+}
+
+void i2c_bus_worker::release(slot &current)
+{
+    current.handler(current, false);
+    free_slots_.enqueue(&current, 0);
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "util/noncopyable.h"
+#include "util/static_queue.h"
+#include "util/task_wrapper.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Runs all transactions of one i2c bus on its own task, in the order they were queued.
+ * A transaction is any code talking to devices on the bus, from a single register read to a complete
+ * driver call. Transactions queued back to back run as one batch, without waking other tasks in between.
+ *
+ * submit() queues a transaction and returns at once with a future, the bus task notifies the submitting task
+ * when it is done. execute() waits for it instead. A transaction not started within its timeout is dropped.
+ * A started one can not be preempted: its caller can stop waiting and abandon it, the result is then thrown
+ * away when it finishes. How long it runs is bounded by the driver only, each transfer gives up after
+ * CONFIG_I2CDEV_TIMEOUT on top of the delays the driver waits itself, so a stuck device still holds up the
+ * transactions queued behind it on the same bus.
+ *
+ * Transactions run from a fixed set of slots, each with its own completion semaphore, so nothing is allocated
+ * per transaction. `ftn` may run after its caller stopped waiting, it must not capture locals by reference.
+ */
+class i2c_bus_worker : esp32::noncopyable
+{
+    struct slot;
+
+  public:
+    template <class F>
+    using execute_result_t = std::conditional_t<std::is_void_v<std::invoke_result_t<F>>, bool, std::invoke_result_t<F>>;
+
+    /**
+     * Result of a submitted transaction, holds its slot until the result is taken or the future is destroyed
+     */
+    template <class T> class future : esp32::noncopyable
+    {
+      public:
+        future() = default;
+
+        future(future &&other) noexcept : worker_(other.worker_), slot_(std::exchange(other.slot_, nullptr))
+        {
+        }
+
+        future &operator=(future &&other) noexcept
+        {
+            abandon();
+            worker_ = other.worker_;
+            slot_ = std::exchange(other.slot_, nullptr);
+            return *this;
+        }
+
+        ~future()
+        {
+            abandon();
+        }
+
+        /**
+         * False if no slot was free when it was submitted, or after get()
+         */
+        bool valid() const
+        {
+            return slot_;
+        }
+
+        bool ready() const
+        {
+            return slot_ && (slot_->state.load(std::memory_order_acquire) == slot_state::done);
+        }
+
+        /**
+         * Started on the bus and not done yet, as opposed to waiting behind other transactions
+         */
+        bool running() const
+        {
+            return slot_ && (slot_->state.load(std::memory_order_acquire) == slot_state::running);
+        }
+
+        /**
+         * Once ready(), the result of `ftn` or std::nullopt if it was not started in time. Exceptions are rethrown.
+         */
+        std::optional<T> get()
+        {
+            auto &result = *static_cast<job_result<T> *>(slot_->result);
+            const auto exception = std::move(result.exception);
+            auto value = std::move(result.value);
+            worker_->release(*std::exchange(slot_, nullptr));
+
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+            return value;
+        }
+
+        /**
+         * Stops waiting for the result, the bus task frees the slot when the transaction is done
+         */
+        void abandon()
+        {
+            if (!slot_)
+            {
+                return;
+            }
+
+            auto state = slot_->state.load(std::memory_order_acquire);
+            while ((state != slot_state::done) && !slot_->state.compare_exchange_weak(state, slot_state::abandoned, std::memory_order_acq_rel))
+            {
+            }
+            if (state == slot_state::done)
+            {
+                worker_->release(*slot_);
+            }
+            slot_ = nullptr;
+        }
+
+      private:
+        friend class i2c_bus_worker;
+
+        future(i2c_bus_worker &worker, slot &current) : worker_(&worker), slot_(&current)
+        {
+        }
+
+        i2c_bus_worker *worker_{};
+        slot *slot_{};
+    };
+
+    i2c_bus_worker();
+
+    void begin(const char *name, uint32_t priority, BaseType_t core);
+
+    /**
+     * Queues `ftn` as a transaction without waiting. The calling task gets a notification (xTaskNotifyGive)
+     * when it is done. The future is not valid if all slots are in use.
+     */
+    template <class F> future<execute_result_t<F>> submit(F &&ftn, TickType_t timeout)
+    {
+        slot *current;
+        if (!free_slots_.dequeue(current, 0))
+        {
+            return {};
+        }
+        return start(*current, std::forward<F>(ftn), xTaskGetTickCount() + timeout, xTaskGetCurrentTaskHandle());
+    }
+
+    /**
+     * Runs `ftn` as a transaction and waits for it. Returns std::nullopt if it did not finish within `timeout`,
+     * the result of `ftn` otherwise, or true if it returns void. Exceptions are rethrown in the caller.
+     * Called from the bus task itself, `ftn` runs inline.
+     */
+    template <class F> std::optional<execute_result_t<F>> execute(F &&ftn, TickType_t timeout)
+    {
+        if (xTaskGetCurrentTaskHandle() == worker_task_.handle())
+        {
+            return invoke(ftn);
+        }
+
+        const auto deadline = xTaskGetTickCount() + timeout;
+        slot *current;
+        if (!free_slots_.dequeue(current, timeout))
+        {
+            return std::nullopt;
+        }
+
+        auto pending = start(*current, std::forward<F>(ftn), deadline, nullptr);
+        while (!pending.ready())
+        {
+            // the semaphore can still be given from an earlier use of the slot, so it is only a wake up
+            const auto remaining = static_cast<int32_t>(deadline - xTaskGetTickCount());
+            if ((remaining <= 0) || (xSemaphoreTake(current->done, remaining) != pdTRUE))
+            {
+                return std::nullopt;
+            }
+        }
+        return pending.get();
+    }
+
+  private:
+    static constexpr size_t slot_count = 8;
+    static constexpr size_t slot_storage_size = 160;
+
+    enum class slot_state : uint8_t
+    {
+        queued,
+        running,
+        done,
+        abandoned,
+    };
+
+    struct slot
+    {
+        // runs the job, or only destroys it if `run` is false
+        void (*handler)(slot &current, bool run);
+        void *result; // job_result of the job
+        std::atomic<slot_state> state{slot_state::done};
+        TickType_t deadline; // to start by
+        TaskHandle_t notify;
+        SemaphoreHandle_t done;
+        StaticSemaphore_t done_buffer;
+        alignas(std::max_align_t) std::array<std::byte, slot_storage_size> storage;
+    };
+
+    template <class T> struct job_result
+    {
+        std::optional<T> value{};
+        std::exception_ptr exception{};
+    };
+
+    template <class F> struct job : job_result<execute_result_t<F>>
+    {
+        explicit job(F &&ftn) : ftn(std::move(ftn))
+        {
+        }
+
+        F ftn;
+    };
+
+    std::array<slot, slot_count> slots_;
+    esp32::static_queue<slot *, slot_count> free_slots_;
+    esp32::static_queue<slot *, slot_count> queue_;
+    esp32::task worker_task_;
+
+    void worker_task_ftn();
+    void run(slot &current);
+    void release(slot &current);
+
+    template <class F> future<execute_result_t<F>> start(slot &current, F &&ftn, TickType_t deadline, TaskHandle_t notify)
+    {
+        using job_t = job<std::decay_t<F>>;
+        static_assert(sizeof(job_t) <= slot_storage_size && alignof(job_t) <= alignof(std::max_align_t), "Transaction too large for a slot");
+
+        auto &pending = *new (current.storage.data()) job_t{std::decay_t<F>(std::forward<F>(ftn))};
+        current.handler = &run_job<job_t>;
+        current.result = static_cast<job_result<execute_result_t<F>> *>(&pending);
+        current.deadline = deadline;
+        current.notify = notify;
+        current.state.store(slot_state::queued, std::memory_order_release);
+        queue_.enqueue(&current, portMAX_DELAY); // never blocks, the queue holds all slots
+        return {*this, current};
+    }
+
+    template <class J> static void run_job(slot &current, bool run)
+    {
+        auto &pending = *std::launder(reinterpret_cast<J *>(current.storage.data()));
+        if (!run)
+        {
+            pending.~J();
+            return;
+        }
+
+        try
+        {
+            pending.value.emplace(invoke(pending.ftn));
+        }
+        catch (...)
+        {
+            pending.exception = std::current_exception();
+        }
+    }
+
+    template <class F> static execute_result_t<F> invoke(F &ftn)
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<F>>)
+        {
+            ftn();
+            return true;
+        }
+        else
+        {
+            return ftn();
+        }
+    }
+};
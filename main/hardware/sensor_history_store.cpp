@@ -0,0 +1,583 @@
+#include "hardware/sensor_history_store.h"
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+#include "hardware/sd_card.h"
+#include "logging/logging_tags.h"
+#include "util/binary_io.h"
+#include "util/cores.h"
+#include "util/filesystem/file.h"
+#include "util/filesystem/file_info.h"
+#include "util/filesystem/filesystem.h"
+#include "util/helper.h"
+#include <algorithm>
+#include <cmath>
+#include <dirent.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <mutex>
+#include <string>
+#include <time.h>
+
+namespace
+{
+// file names are 8.3 as long file names are not enabled for fat
+constexpr char segment_extension[] = ".seg";
+constexpr uint32_t frame_magic = 0x52514146;      // 'FAQR'
+constexpr uint32_t checkpoint_magic = 0x48514143; // 'CAQH'
+constexpr uint16_t checkpoint_version = 4;
+
+// a longer downtime leaves nothing of the history, the hour tier covers 90 days
+constexpr uint32_t max_gap_seconds = 90 * 24 * 60 * 60;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t count;
+    uint16_t reserved;
+    uint32_t time; // system time in seconds when the newest record was added
+    uint32_t crc;  // of the records
+} frame_header;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint8_t sensor_count;
+    uint8_t reserved;
+    uint32_t first_segment; // segments from this one are replayed on top of the checkpoint
+    uint32_t time;          // system time in seconds when the checkpoint was taken
+} checkpoint_header;
+// followed by included records per sensor, the histories and the crc
+
+uint32_t crc32(const uint8_t *data, size_t size)
+{
+    return esp_rom_crc32_le(0, data, size);
+}
+
+uint32_t get_system_time()
+{
+    return static_cast<uint32_t>(time(nullptr));
+}
+
+/**
+ * System time comes from the rtc timer, which keeps running through software resets and watchdogs
+ * but starts again from 0 on power on
+ */
+bool is_system_time_kept()
+{
+    switch (esp_reset_reason())
+    {
+    case ESP_RST_SW:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_DEEPSLEEP:
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+sensor_history_store::sensor_history_store(sd_card &sd_card, histories_t &histories)
+    : sd_card_(sd_card), histories_(histories), writer_task_([this] { writer_task_ftn(); }),
+      history_path_(std::filesystem::path(sd_card::mount_point) / "history"), checkpoint_path_(history_path_ / "ckpt.bin"),
+      checkpoint_temp_path_(history_path_ / "ckpt.tmp")
+{
+}
+
+void sensor_history_store::restore()
+{
+    if (!sd_card_.is_mounted())
+    {
+        ESP_LOGW(HARDWARE_TAG, "No SD Card found, sensor history is not persisted");
+        return;
+    }
+
+    const auto start = esp_timer_get_time();
+    try
+    {
+        esp32::filesystem::create_directory(history_path_);
+
+        // a crash between removing the old checkpoint and renaming the new one leaves only the temp file
+        auto checkpoint = load_checkpoint(checkpoint_path_);
+        if (!checkpoint.has_value())
+        {
+            checkpoint = load_checkpoint(checkpoint_temp_path_);
+        }
+
+        const uint32_t first_segment = checkpoint.has_value() ? checkpoint->first_segment : 0;
+        std::optional<uint32_t> last_time;
+        if (checkpoint.has_value())
+        {
+            last_time = checkpoint->time;
+        }
+
+        size_t replayed = 0;
+        uint32_t next_segment = first_segment;
+        for (auto &&segment : list_segments())
+        {
+            if (segment >= first_segment)
+            {
+                // the first records may have been added while the checkpoint was serialized, so it already has them
+                write_counts_t skipped_writes{};
+                if (checkpoint.has_value() && (segment == first_segment))
+                {
+                    skipped_writes = checkpoint->included_writes;
+                }
+                replayed += replay_segment(segment, skipped_writes, last_time);
+                next_segment = segment + 1;
+            }
+        }
+        remove_segments_before(first_segment);
+
+        // never append after a possibly torn tail, always start a new segment
+        std::lock_guard<esp32::semaphore> lock(data_mutex_);
+        current_segment_ = next_segment;
+        enabled_ = true;
+        if (last_time.has_value())
+        {
+            add_downtime(last_time.value());
+        }
+
+        ESP_LOGI(HARDWARE_TAG, "Restored sensor history in %lld ms, checkpoint:%s, replayed values:%u", (esp_timer_get_time() - start) / 1000,
+                 checkpoint.has_value() ? "yes" : "no", replayed);
+    }
+    catch (const std::exception &ex)
+    {
+        ESP_LOGE(HARDWARE_TAG, "Failed to restore sensor history with :%s", ex.what());
+        for (auto &&history : histories_)
+        {
+            history.clear();
+        }
+    }
+}
+
+void sensor_history_store::begin()
+{
+    if (enabled_)
+    {
+        writer_task_.spawn_pinned("history_writer", 4 * 1024, tskIDLE_PRIORITY, esp32::main_task_core);
+    }
+}
+
+void sensor_history_store::add_value(sensor_id_index index, float value)
+{
+    std::lock_guard<esp32::semaphore> lock(data_mutex_);
+    histories_[static_cast<size_t>(index)].add_value(value);
+    push_record(index, value, 1);
+}
+
+void sensor_history_store::clear(sensor_id_index index)
+{
+    std::lock_guard<esp32::semaphore> lock(data_mutex_);
+    histories_[static_cast<size_t>(index)].clear();
+    push_record(index, NAN, 0);
+}
+
+void sensor_history_store::flush()
+{
+    std::lock_guard<esp32::semaphore> write_lock(write_mutex_);
+    records_t records;
+    uint32_t segment;
+    uint32_t time;
+    {
+        std::lock_guard<esp32::semaphore> lock(data_mutex_);
+        records = take_pending();
+        segment = current_segment_;
+        time = pending_time_;
+    }
+
+    append_to_segment(segment, records, time);
+}
+
+/**
+ * Must be called with data_mutex_ held. A record has to match a single history write, except that a value
+ * is added to the pending record of the same value, as one write per interval.
+ */
+void sensor_history_store::push_record(sensor_id_index index, float value, uint16_t count)
+{
+    if (enabled_)
+    {
+        auto &run = pending_runs_[static_cast<size_t>(index)];
+        if (!std::isnan(value) && run && (pending_[run - 1].value == value) && (pending_[run - 1].count <= UINT16_MAX - count))
+        {
+            pending_[run - 1].count += count;
+        }
+        else
+        {
+            pending_.push_back({static_cast<uint8_t>(index), value, count});
+            // gaps and clears end a run
+            run = std::isnan(value) ? 0 : pending_.size();
+        }
+        pending_time_ = get_system_time();
+    }
+}
+
+/**
+ * Must be called with data_mutex_ held, later values start new records
+ */
+sensor_history_store::records_t sensor_history_store::take_pending()
+{
+    records_t records;
+    records.swap(pending_);
+    pending_runs_.fill(0);
+    return records;
+}
+
+/**
+ * Adds the time since `last_time` as a gap to every history, or clears them if it is unknown.
+ * Must be called with data_mutex_ held.
+ */
+void sensor_history_store::add_downtime(uint32_t last_time)
+{
+    const auto now = get_system_time();
+    if (!is_system_time_kept() || (now < last_time) || (now - last_time > max_gap_seconds))
+    {
+        ESP_LOGW(HARDWARE_TAG, "Cleared sensor history, the time the device was off is unknown or too long");
+        for (size_t i = 0; i < total_sensors; i++)
+        {
+            const auto index = static_cast<sensor_id_index>(i);
+            histories_[i].clear();
+            push_record(index, NAN, 0);
+        }
+        return;
+    }
+
+    const uint32_t gap = static_cast<uint64_t>(now - last_time) * 1000 / sensor_history::sensor_interval;
+    for (size_t i = 0; i < total_sensors; i++)
+    {
+        const auto index = static_cast<sensor_id_index>(i);
+        for (uint32_t remaining = gap; remaining;)
+        {
+            const uint16_t count = std::min<uint32_t>(remaining, UINT16_MAX);
+            histories_[i].add_gap(count);
+            push_record(index, NAN, count);
+            remaining -= count;
+        }
+    }
+
+    ESP_LOGI(HARDWARE_TAG, "Added %lu seconds of downtime to the sensor history", now - last_time);
+}
+
+void sensor_history_store::writer_task_ftn()
+{
+    uint32_t flushes = 0;
+    do
+    {
+        vTaskDelay(pdMS_TO_TICKS(flush_interval_ms));
+        try
+        {
+            if (++flushes % checkpoint_every_flushes == 0)
+            {
+                checkpoint();
+            }
+            else
+            {
+                flush();
+            }
+        }
+        catch (const std::exception &ex)
+        {
+            ESP_LOGE(HARDWARE_TAG, "Failed to write sensor history with :%s", ex.what());
+        }
+    } while (true);
+}
+
+void sensor_history_store::checkpoint()
+{
+    const auto start = esp_timer_get_time();
+
+    std::lock_guard<esp32::semaphore> write_lock(write_mutex_);
+    records_t records;
+    uint32_t segment;
+    uint32_t time;
+    uint32_t checkpoint_time;
+    write_counts_t write_counts;
+    {
+        // values added after this point go to the next segment, the histories are serialized without the lock
+        std::lock_guard<esp32::semaphore> lock(data_mutex_);
+        records = take_pending();
+        segment = current_segment_++;
+        time = pending_time_;
+        checkpoint_time = get_system_time();
+        for (size_t i = 0; i < total_sensors; i++)
+        {
+            write_counts[i] = histories_[i].write_count();
+        }
+    }
+
+    append_to_segment(segment, records, time);
+
+    buffer_t buffer;
+    serialize_checkpoint(segment + 1, checkpoint_time, write_counts, buffer);
+
+    {
+        esp32::filesystem::file file(checkpoint_temp_path_.c_str(), "wb");
+        if (file.write(buffer.data(), 1, buffer.size()) != buffer.size() || file.flush() != 0)
+        {
+            throw std::runtime_error("Failed to write checkpoint");
+        }
+    }
+
+    esp32::filesystem::remove(checkpoint_path_);
+    if (!esp32::filesystem::rename(checkpoint_temp_path_, checkpoint_path_))
+    {
+        throw std::runtime_error("Failed to rename checkpoint");
+    }
+
+    remove_segments_before(segment + 1);
+
+    ESP_LOGI(HARDWARE_TAG, "Sensor history checkpoint of %u bytes written in %lld ms", buffer.size(), (esp_timer_get_time() - start) / 1000);
+}
+
+void sensor_history_store::append_to_segment(uint32_t segment, const records_t &records, uint32_t time)
+{
+    if (records.empty())
+    {
+        return;
+    }
+
+    buffer_t buffer;
+    buffer.reserve(records.size() * sizeof(record) + sizeof(frame_header));
+    for (size_t offset = 0; offset < records.size(); offset += UINT16_MAX)
+    {
+        const auto count = std::min<size_t>(records.size() - offset, UINT16_MAX);
+        const auto data = reinterpret_cast<const uint8_t *>(records.data() + offset);
+
+        frame_header header{};
+        header.magic = frame_magic;
+        header.count = count;
+        header.time = time;
+        header.crc = crc32(data, count * sizeof(record));
+
+        const auto header_data = reinterpret_cast<const uint8_t *>(&header);
+        buffer.insert(buffer.end(), header_data, header_data + sizeof(header));
+        buffer.insert(buffer.end(), data, data + count * sizeof(record));
+    }
+
+    esp32::filesystem::file file(get_segment_path(segment).c_str(), "ab");
+    if (file.write(buffer.data(), 1, buffer.size()) != buffer.size() || file.flush() != 0)
+    {
+        throw std::runtime_error("Failed to write history segment");
+    }
+}
+
+/**
+ * Each history is copied while values keep being added, `write_counts` of when the records were swapped tell
+ * how many of the writes now going to `first_segment` made it into the copy
+ */
+void sensor_history_store::serialize_checkpoint(uint32_t first_segment, uint32_t time, const write_counts_t &write_counts, buffer_t &buffer)
+{
+    esp32::binary_io::memory_writer writer(buffer);
+
+    checkpoint_header header{};
+    header.magic = checkpoint_magic;
+    header.version = checkpoint_version;
+    header.sensor_count = total_sensors;
+    header.first_segment = first_segment;
+    header.time = time;
+    esp32::binary_io::write(writer, header);
+
+    write_counts_t included_writes{};
+    const auto included_writes_offset = buffer.size();
+    esp32::binary_io::write(writer, included_writes);
+
+    for (size_t i = 0; i < total_sensors; i++)
+    {
+        included_writes[i] = histories_[i].save(buffer) - write_counts[i];
+    }
+    memcpy(buffer.data() + included_writes_offset, included_writes.data(), sizeof(included_writes));
+
+    esp32::binary_io::write(writer, crc32(buffer.data(), buffer.size()));
+}
+
+std::optional<sensor_history_store::checkpoint_state> sensor_history_store::load_checkpoint(const std::filesystem::path &path)
+{
+    const auto buffer = read_file(path);
+    if (!buffer.has_value() || buffer->size() < sizeof(checkpoint_header) + sizeof(uint32_t))
+    {
+        return std::nullopt;
+    }
+
+    const auto size = buffer->size() - sizeof(uint32_t);
+    uint32_t crc;
+    memcpy(&crc, buffer->data() + size, sizeof(crc));
+    if (crc != crc32(buffer->data(), size))
+    {
+        ESP_LOGW(HARDWARE_TAG, "Ignoring corrupt history checkpoint:%s", path.c_str());
+        return std::nullopt;
+    }
+
+    esp32::binary_io::memory_reader reader(buffer->data(), size);
+    checkpoint_header header;
+    checkpoint_state state;
+    esp32::binary_io::read(reader, header);
+    if (header.magic != checkpoint_magic || header.version != checkpoint_version || header.sensor_count != total_sensors ||
+        !esp32::binary_io::read(reader, state.included_writes))
+    {
+        ESP_LOGW(HARDWARE_TAG, "Ignoring incompatible history checkpoint:%s", path.c_str());
+        return std::nullopt;
+    }
+
+    for (auto &&history : histories_)
+    {
+        if (!history.load(reader))
+        {
+            ESP_LOGW(HARDWARE_TAG, "Failed to load history checkpoint:%s", path.c_str());
+            for (auto &&value : histories_)
+            {
+                value.clear();
+            }
+            return std::nullopt;
+        }
+    }
+
+    state.first_segment = header.first_segment;
+    state.time = header.time;
+    return state;
+}
+
+/**
+ * Skips the first `skipped_writes` of each sensor and updates `last_time` to the time of the last frame
+ */
+size_t sensor_history_store::replay_segment(uint32_t segment, write_counts_t &skipped_writes, std::optional<uint32_t> &last_time)
+{
+    const auto path = get_segment_path(segment);
+    const auto buffer = read_file(path);
+    if (!buffer.has_value())
+    {
+        return 0;
+    }
+
+    size_t replayed = 0;
+    size_t offset = 0;
+    while (offset < buffer->size())
+    {
+        // the tail can be torn by a crash or power loss while writing, stop at the first bad frame
+        frame_header header;
+        if (buffer->size() - offset < sizeof(header))
+        {
+            break;
+        }
+        memcpy(&header, buffer->data() + offset, sizeof(header));
+
+        const auto data = buffer->data() + offset + sizeof(header);
+        const auto data_size = header.count * sizeof(record);
+        if (header.magic != frame_magic || buffer->size() - offset - sizeof(header) < data_size || header.crc != crc32(data, data_size))
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < header.count; i++)
+        {
+            record value;
+            memcpy(&value, data + i * sizeof(record), sizeof(record));
+            if (value.index >= total_sensors)
+            {
+                continue;
+            }
+
+            auto &skipped = skipped_writes[value.index];
+            if (!std::isnan(value.value))
+            {
+                // a run of values is one write per interval, the checkpoint can have part of it
+                const auto skip = std::min<uint32_t>(skipped, value.count);
+                skipped -= skip;
+                if (value.count > skip)
+                {
+                    histories_[value.index].add_value(value.value, value.count - skip);
+                }
+            }
+            else if (skipped)
+            {
+                skipped--;
+            }
+            else if (value.count)
+            {
+                histories_[value.index].add_gap(value.count);
+            }
+            else
+            {
+                histories_[value.index].clear();
+            }
+        }
+
+        last_time = header.time;
+        replayed += header.count;
+        offset += sizeof(header) + data_size;
+    }
+
+    if (offset != buffer->size())
+    {
+        ESP_LOGW(HARDWARE_TAG, "Discarded %u bytes from the tail of %s", buffer->size() - offset, path.c_str());
+    }
+    return replayed;
+}
+
+void sensor_history_store::remove_segments_before(uint32_t segment)
+{
+    for (auto &&value : list_segments())
+    {
+        if (value < segment)
+        {
+            esp32::filesystem::remove(get_segment_path(value));
+        }
+    }
+}
+
+std::vector<uint32_t> sensor_history_store::list_segments() const
+{
+    std::vector<uint32_t> segments;
+    auto dir = opendir(history_path_.c_str());
+    if (dir == nullptr)
+    {
+        return segments;
+    }
+
+    const std::string_view extension{segment_extension};
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        // fat returns upper case names
+        std::string name{entry->d_name};
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (name.size() > extension.size() && name.ends_with(extension))
+        {
+            name.resize(name.size() - extension.size());
+            const auto segment = esp32::string::parse_number<uint32_t>(name);
+            if (segment.has_value())
+            {
+                segments.push_back(segment.value());
+            }
+        }
+    }
+    closedir(dir);
+
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+std::filesystem::path sensor_history_store::get_segment_path(uint32_t segment) const
+{
+    return history_path_ / (esp32::string::to_string(segment) + segment_extension);
+}
+
+std::optional<sensor_history_store::buffer_t> sensor_history_store::read_file(const std::filesystem::path &path)
+{
+    const esp32::filesystem::file_info info{path};
+    if (!info.exists() || !info.is_regular_file())
+    {
+        return std::nullopt;
+    }
+
+    // a single read is much faster on the sd card than many small ones
+    buffer_t buffer(info.size());
+    esp32::filesystem::file file(path.c_str(), "rb");
+    buffer.resize(file.read(buffer.data(), 1, buffer.size()));
+    return buffer;
+}
+
+#endif
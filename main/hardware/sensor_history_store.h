@@ -0,0 +1,110 @@
+#pragma once
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+
+#include "hardware/sensors/sensor.h"
+#include "util/noncopyable.h"
+#include "util/psram_allocator.h"
+#include "util/semaphore_lockable.h"
+#include "util/task_wrapper.h"
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+class sd_card;
+
+/**
+ * Persists sensor history to the sd card as an append-only segment log plus periodic checkpoints.
+ * Values are batched in memory and appended as crc protected frames every few minutes, consecutive intervals
+ * with the same value are batched as one record with a count. A checkpoint
+ * holds the full history state and names the first segment to replay on top of it, older segments
+ * are deleted once the checkpoint is written.
+ * Frames and checkpoints carry the system time, which survives software resets, so that the time the device
+ * was off is added to the history as a gap on restore. After a power on reset that time is unknown and the
+ * history is cleared instead.
+ * All history updates go through this class so that checkpoints are consistent with the log.
+ */
+class sensor_history_store : esp32::noncopyable
+{
+  public:
+    using histories_t = std::array<sensor_history, total_sensors>;
+
+    sensor_history_store(sd_card &sd_card, histories_t &histories);
+
+    /**
+     * Loads the last checkpoint, replays the segments after it and adds the downtime since, must be called
+     * before values are added
+     */
+    void restore();
+    void begin();
+
+    /**
+     * Adds the value for one history interval
+     */
+    void add_value(sensor_id_index index, float value);
+    void clear(sensor_id_index index);
+
+    /**
+     * Writes pending values to the current segment
+     */
+    void flush();
+
+  private:
+    typedef struct __attribute__((packed))
+    {
+        uint8_t index;
+        float value;    // NaN is a gap of count intervals, or clears the history with a count of 0
+        uint16_t count; // consecutive intervals with this value, each one a history write
+    } record;
+
+    using records_t = std::vector<record, esp32::psram::allocator<record>>;
+    using buffer_t = std::vector<uint8_t, esp32::psram::allocator<uint8_t>>;
+    using write_counts_t = std::array<uint32_t, total_sensors>;
+
+    typedef struct
+    {
+        uint32_t first_segment;
+        uint32_t time;
+        write_counts_t included_writes; // history writes at the start of first_segment already in the checkpoint
+    } checkpoint_state;
+
+    static constexpr uint32_t flush_interval_ms = 5 * 60 * 1000;
+    static constexpr uint32_t checkpoint_every_flushes = 12; // hourly
+
+    sd_card &sd_card_;
+    histories_t &histories_;
+
+    esp32::semaphore data_mutex_;
+    bool enabled_{false};
+    records_t pending_;
+    std::array<uint32_t, total_sensors> pending_runs_{}; // 1 + index in pending_ of the record a value can be added to
+    uint32_t pending_time_{0}; // of the newest pending record
+    uint32_t current_segment_{0};
+
+    esp32::semaphore write_mutex_;
+    esp32::task writer_task_;
+
+    const std::filesystem::path history_path_;
+    const std::filesystem::path checkpoint_path_;
+    const std::filesystem::path checkpoint_temp_path_;
+
+    void writer_task_ftn();
+    void push_record(sensor_id_index index, float value, uint16_t count);
+    void add_downtime(uint32_t last_time);
+    void checkpoint();
+    void append_to_segment(uint32_t segment, const records_t &records, uint32_t time);
+    records_t take_pending();
+    void serialize_checkpoint(uint32_t first_segment, uint32_t time, const write_counts_t &write_counts, buffer_t &buffer);
+    std::optional<checkpoint_state> load_checkpoint(const std::filesystem::path &path);
+    size_t replay_segment(uint32_t segment, write_counts_t &skipped_writes, std::optional<uint32_t> &last_time);
+    void remove_segments_before(uint32_t segment);
+
+    std::vector<uint32_t> list_segments() const;
+    std::filesystem::path get_segment_path(uint32_t segment) const;
+    static std::optional<buffer_t> read_file(const std::filesystem::path &path);
+};
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+
+/**
+ * Read interval of a device which follows how fast its values change. Any significant change goes
+ * straight back to the fast interval, flat readings double it up to the slow one.
+ */
+class adaptive_read_interval
+{
+  public:
+    uint32_t next(bool changed, uint32_t fast_ms, uint32_t slow_ms)
+    {
+        interval_ = changed ? fast_ms : std::clamp<uint32_t>(interval_ * 2, fast_ms, slow_ms);
+        return interval_;
+    }
+
+    uint32_t get() const
+    {
+        return interval_;
+    }
+
+  private:
+    uint32_t interval_{0};
+};
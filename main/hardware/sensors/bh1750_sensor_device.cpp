@@ -16,7 +16,7 @@ void bh1750_sensor_device::init()
     CHECK_THROW_ESP(bh1750_setup(&bh1750_sensor_, BH1750_MODE_CONTINUOUS, BH1750_RES_HIGH));
 }
 
-std::array<std::tuple<sensor_id_index, float>, 1> bh1750_sensor_device::read()
+optional_sensor_reading<1> bh1750_sensor_device::read()
 {
     float lux = NAN;
     uint16_t level_lux = 0;
@@ -24,13 +24,14 @@ std::array<std::tuple<sensor_id_index, float>, 1> bh1750_sensor_device::read()
     if (err != ESP_OK)
     {
         ESP_LOGW(SENSOR_BH1750_TAG, "Failed to read sensor with %s", esp_err_to_name(err));
+        stats_.record_error(err);
     }
     else
     {
         lux = level_lux;
     }
 
-    return {std::tuple<sensor_id_index, float>{sensor_id_index::light_intensity, esp32::round_with_precision(lux, 1)}};
+    return sensor_reading<1>{esp32::millis(), {std::tuple<sensor_id_index, float>{sensor_id_index::light_intensity, esp32::round_with_precision(lux, 1)}}};
 }
 
 TickType_t bh1750_sensor_device::get_initial_delay()
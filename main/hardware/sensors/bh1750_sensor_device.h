@@ -1,6 +1,8 @@
 #pragma once
 
+#include "hardware/sensors/sensor_device_stats.h"
 #include "hardware/sensors/sensor_id.h"
+#include "hardware/sensors/sensor_reading.h"
 #include "util/singleton.h"
 #include <array>
 #include <i2cdev.h>
@@ -11,12 +13,18 @@ class bh1750_sensor_device final : public esp32::singleton<bh1750_sensor_device>
 {
   public:
     void init();
-    std::array<std::tuple<sensor_id_index, float>, 1> read();
+    optional_sensor_reading<1> read();
+
+    sensor_device_stats &get_stats()
+    {
+        return stats_;
+    }
 
     TickType_t get_initial_delay();
 
   private:
     i2c_dev_t bh1750_sensor_{};
+    sensor_device_stats stats_{"BH1750"};
 
     bh1750_sensor_device() = default;
     friend class esp32::singleton<bh1750_sensor_device>;
@@ -0,0 +1,117 @@
+#include "hardware/sensors/replay_sensor_device.h"
+
+#ifdef CONFIG_SENSOR_REPLAY_ENABLE
+#include "logging/logging_tags.h"
+#include "util/exceptions.h"
+#include "util/misc.h"
+#include <cstdlib>
+#include <esp_log.h>
+
+void replay_sensor_device::init()
+{
+    file_ = std::make_unique<esp32::filesystem::file>(CONFIG_SENSOR_REPLAY_FILE, "r");
+    if (!restart())
+    {
+        CHECK_THROW_ESP2(ESP_ERR_INVALID_SIZE, "sensor trace has no rows");
+    }
+    ESP_LOGI(SENSOR_REPLAY_TAG, "Replaying %s at %dx", CONFIG_SENSOR_REPLAY_FILE, CONFIG_SENSOR_REPLAY_SPEED);
+}
+
+optional_sensor_reading<5> replay_sensor_device::read()
+{
+    const uint32_t now = esp32::millis();
+
+    // skip to the latest due row, as the device only keeps its last measurement
+    std::optional<trace_row> due_row;
+    while (true)
+    {
+        if (!next_row_.has_value())
+        {
+            next_row_ = read_row();
+            if (!next_row_.has_value())
+            {
+                if (due_row.has_value())
+                {
+                    break; // return the last row first
+                }
+
+                ESP_LOGI(SENSOR_REPLAY_TAG, "Trace ended after %lu rows, starting over", rows_replayed_);
+                if (!restart())
+                {
+                    stats_.record_error(ESP_ERR_INVALID_SIZE);
+                    return std::nullopt;
+                }
+            }
+        }
+
+        const auto trace_elapsed = (next_row_->time - trace_start_) / CONFIG_SENSOR_REPLAY_SPEED;
+        if (trace_elapsed > now - replay_start_)
+        {
+            break;
+        }
+
+        due_row = next_row_;
+        next_row_.reset();
+        rows_replayed_++;
+    }
+
+    if (!due_row.has_value())
+    {
+        ESP_LOGD(SENSOR_REPLAY_TAG, "No new measurement");
+        return std::nullopt;
+    }
+
+    // same order as sps30_sensor_device
+    const auto &values = due_row->values;
+    return sensor_reading<5>{now,
+                             {std::tuple<sensor_id_index, float>{sensor_id_index::pm_10, values[3]},
+                              std::tuple<sensor_id_index, float>{sensor_id_index::pm_1, values[1]},
+                              std::tuple<sensor_id_index, float>{sensor_id_index::pm_2_5, values[0]},
+                              std::tuple<sensor_id_index, float>{sensor_id_index::pm_4, values[2]},
+                              std::tuple<sensor_id_index, float>{sensor_id_index::typical_particle_size, values[4]}}};
+}
+
+std::optional<replay_sensor_device::trace_row> replay_sensor_device::read_row()
+{
+    std::array<char, 128> line;
+    while (file_->read_line(line.data(), line.size()))
+    {
+        // header and comment lines do not start with the time
+        char *end;
+        const auto time = std::strtoul(line.data(), &end, 10);
+        if (end == line.data())
+        {
+            continue;
+        }
+
+        // an empty or bad value is invalid, same as a failed device read
+        trace_row row{static_cast<uint32_t>(time), {}};
+        for (auto &&value : row.values)
+        {
+            char *value_start = (*end == ',') ? end + 1 : end;
+            value = std::strtof(value_start, &end);
+            if (end == value_start)
+            {
+                value = NAN;
+            }
+        }
+        return row;
+    }
+    return std::nullopt;
+}
+
+bool replay_sensor_device::restart()
+{
+    file_->seek(0, SEEK_SET);
+    next_row_ = read_row();
+    if (!next_row_.has_value())
+    {
+        return false;
+    }
+
+    trace_start_ = next_row_->time;
+    replay_start_ = esp32::millis();
+    rows_replayed_ = 0;
+    return true;
+}
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#include "sdkconfig.h"
+
+#ifdef CONFIG_SENSOR_REPLAY_ENABLE
+#include "hardware/sensors/sensor_device_stats.h"
+#include "hardware/sensors/sensor_id.h"
+#include "hardware/sensors/sensor_reading.h"
+#include "hardware/sensors/sps30_sensor_device.h"
+#include "util/filesystem/file.h"
+#include "util/singleton.h"
+#include <array>
+#include <memory>
+#include <optional>
+
+/**
+ * Stands in for the SPS30, replaying a recorded trace from the SD card at CONFIG_SENSOR_REPLAY_SPEED times real time.
+ * Like the device it returns the latest row which is due, so the rest of the pipeline runs unchanged.
+ * The trace starts over at its end.
+ */
+class replay_sensor_device final : public esp32::singleton<replay_sensor_device>
+{
+  public:
+    static constexpr uint32_t measurement_interval_ms = sps30_sensor_device::measurement_interval_ms;
+
+    void init();
+    optional_sensor_reading<5> read();
+
+    sensor_device_stats &get_stats()
+    {
+        return stats_;
+    }
+
+  private:
+    struct trace_row
+    {
+        uint32_t time; // ms in the trace
+        std::array<float, 5> values;
+    };
+
+    std::unique_ptr<esp32::filesystem::file> file_;
+    std::optional<trace_row> next_row_; // read ahead, not due yet
+    uint32_t trace_start_{0};           // time of the first row
+    uint32_t replay_start_{0};          // esp32::millis() when the trace (re)started
+    uint32_t rows_replayed_{0};
+    sensor_device_stats stats_{"Replay"};
+
+    std::optional<trace_row> read_row();
+    bool restart();
+
+    replay_sensor_device() = default;
+    friend class esp32::singleton<replay_sensor_device>;
+};
+#endif
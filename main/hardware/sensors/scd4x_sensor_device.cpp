@@ -36,7 +36,7 @@ void scd4x_sensor_device::init()
     CHECK_THROW_ESP(scd4x_start_low_power_periodic_measurement(&scd4x_sensor_));
 }
 
-std::array<std::tuple<sensor_id_index, float>, 4> scd4x_sensor_device::read()
+optional_sensor_reading<4> scd4x_sensor_device::read()
 {
     float co2 = NAN;
     float temperatureC = NAN;
@@ -48,40 +48,38 @@ std::array<std::tuple<sensor_id_index, float>, 4> scd4x_sensor_device::read()
 
     if ((error == ESP_OK))
     {
-        if (ready)
+        if (!ready)
         {
-            uint16_t co2_int;
-            auto err = scd4x_read_measurement(&scd4x_sensor_, &co2_int, &temperatureC, &humidity);
-            if (err == ESP_OK)
-            {
-                co2 = co2_int;
-                temperatureF = (temperatureC * 1.8) + 32;
-                ESP_LOGI(SENSOR_SCD4x_TAG, "Read SCD40 sensor values:%g ppm %g F, %g C  %g %%", co2, temperatureF, temperatureC, humidity);
-            }
-            else
-            {
-                ESP_LOGE(SENSOR_SCD4x_TAG, "Failed to read from SCD40 sensor with error:%s", esp_err_to_name(err));
-            }
-            last_measurement_value_.store(std::tie(co2, temperatureC, temperatureF, humidity));
+            ESP_LOGD(SENSOR_SCD4x_TAG, "No new measurement");
+            return std::nullopt;
+        }
+
+        uint16_t co2_int;
+        auto err = scd4x_read_measurement(&scd4x_sensor_, &co2_int, &temperatureC, &humidity);
+        if (err == ESP_OK)
+        {
+            co2 = co2_int;
+            temperatureF = (temperatureC * 1.8) + 32;
+            ESP_LOGI(SENSOR_SCD4x_TAG, "Read SCD40 sensor values:%g ppm %g F, %g C  %g %%", co2, temperatureF, temperatureC, humidity);
         }
         else
         {
-            std::tuple<float, float, float, float> old_values;
-            if (last_measurement_value_.update(old_values))
-            {
-                std::tie(co2, temperatureC, temperatureF, humidity) = old_values;
-            }
+            ESP_LOGE(SENSOR_SCD4x_TAG, "Failed to read from SCD40 sensor with error:%s", esp_err_to_name(err));
+            stats_.record_error(err);
         }
     }
     else
     {
         ESP_LOGE(SENSOR_SCD4x_TAG, "Failed to read from SCD40 sensor with failed to read measurement error:0x%x", error);
+        stats_.record_error(error);
     }
 
-    return {std::tuple<sensor_id_index, float>{sensor_id_index::temperatureC, esp32::round_with_precision(temperatureC, 0.01)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::temperatureF, esp32::round_with_precision(temperatureF, 0.1)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::CO2, esp32::round_with_precision(co2, 1)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::humidity, esp32::round_with_precision(humidity, 1)}};
+    return sensor_reading<4>{
+        esp32::millis(),
+        {std::tuple<sensor_id_index, float>{sensor_id_index::temperatureC, esp32::round_with_precision(temperatureC, 0.01)},
+         std::tuple<sensor_id_index, float>{sensor_id_index::temperatureF, esp32::round_with_precision(temperatureF, 0.1)},
+         std::tuple<sensor_id_index, float>{sensor_id_index::CO2, esp32::round_with_precision(co2, 1)},
+         std::tuple<sensor_id_index, float>{sensor_id_index::humidity, esp32::round_with_precision(humidity, 1)}}};
 }
 
 uint8_t scd4x_sensor_device::get_initial_delay()
@@ -2,8 +2,9 @@
 #include "sdkconfig.h"
 
 #ifdef CONFIG_SCD4x_SENSOR_ENABLE
-#include "hardware/sensors/last_measurement_helper.h"
+#include "hardware/sensors/sensor_device_stats.h"
 #include "hardware/sensors/sensor_id.h"
+#include "hardware/sensors/sensor_reading.h"
 #include "util/singleton.h"
 #include <array>
 #include <i2cdev.h>
@@ -13,8 +14,15 @@
 class scd4x_sensor_device final : public esp32::singleton<scd4x_sensor_device>
 {
   public:
+    static constexpr uint32_t measurement_interval_ms = 30000; // low power periodic mode
+
     void init();
-    std::array<std::tuple<sensor_id_index, float>, 4> read();
+    optional_sensor_reading<4> read();
+
+    sensor_device_stats &get_stats()
+    {
+        return stats_;
+    }
 
     uint8_t get_initial_delay();
 
@@ -22,7 +30,7 @@ class scd4x_sensor_device final : public esp32::singleton<scd4x_sensor_device>
 
   private:
     i2c_dev_t scd4x_sensor_{};
-    last_measurement_helper<std::tuple<float, float, float, float>, 60000> last_measurement_value_;
+    sensor_device_stats stats_{"SCD4x"};
 
     scd4x_sensor_device() = default;
     friend class esp32::singleton<scd4x_sensor_device>;
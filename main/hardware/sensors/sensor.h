@@ -1,16 +1,13 @@
 #pragma once
 
+#include "hardware/sensors/sensor_history.h"
 #include "hardware/sensors/sensor_id.h"
-#include "util/circular_buffer.h"
-#include "util/psram_allocator.h"
-#include "util/semaphore_lockable.h"
 #include <array>
 #include <atomic>
 #include <cmath>
-#include <mutex>
-#include <optional>
+#include <esp_bit_defs.h>
+#include <string_view>
 #include <type_traits>
-#include <vector>
 
 class sensor_definition_display
 {
@@ -50,9 +47,11 @@ class sensor_definition
 {
   public:
     constexpr sensor_definition(const std::string_view &name, const std::string_view &unit, const sensor_definition_display *display_definitions,
-                                size_t display_definitions_count, float min_value, float max_value, float value_step) noexcept
+                                size_t display_definitions_count, float min_value, float max_value, float value_step,
+                                uint8_t notify_deadband_steps, uint32_t min_notify_interval_ms) noexcept
         : name_{name}, unit_(unit), display_definitions_(display_definitions), display_definitions_count_(display_definitions_count),
-          min_value_(min_value), max_value_(max_value), value_step_(value_step)
+          min_value_(min_value), max_value_(max_value), value_step_(value_step), notify_deadband_steps_(notify_deadband_steps),
+          min_notify_interval_ms_(min_notify_interval_ms)
     {
     }
 
@@ -92,6 +91,27 @@ class sensor_definition
         return value_step_;
     }
 
+    /**
+     * Smallest change which is notified right away
+     */
+    constexpr float get_notify_deadband() const noexcept
+    {
+        return notify_deadband_steps_ * value_step_;
+    }
+
+    /**
+     * Small tolerance as the deadband is a multiple of a float step
+     */
+    bool exceeds_notify_deadband(float value1, float value2) const noexcept
+    {
+        return std::fabs(value1 - value2) >= get_notify_deadband() - value_step_ / 100;
+    }
+
+    constexpr uint32_t get_min_notify_interval_ms() const noexcept
+    {
+        return min_notify_interval_ms_;
+    }
+
   private:
     const std::string_view name_;
     const std::string_view unit_;
@@ -100,6 +120,15 @@ class sensor_definition
     const float min_value_;
     const float max_value_;
     const float value_step_;
+    const uint8_t notify_deadband_steps_;
+    const uint32_t min_notify_interval_ms_;
+};
+
+enum class sensor_value_change : uint8_t
+{
+    none,
+    suppressed, // changed, but not enough to notify
+    notify,
 };
 
 class sensor_value
@@ -110,141 +139,94 @@ class sensor_value
         return value_.load();
     }
 
-    bool set_value(float value)
+    sensor_value_change set_value(float value, const sensor_definition &definition, uint32_t now)
     {
-        return set_value_(value);
+        return set_value_(value, definition, now);
     }
 
-    bool set_invalid_value()
+    sensor_value_change set_invalid_value(const sensor_definition &definition, uint32_t now)
     {
-        return set_value_(NAN);
+        return set_value_(NAN, definition, now);
     }
 
   private:
+    // changes smaller than the deadband are still notified after this long
+    static constexpr uint32_t max_notify_interval_ms = 60 * 1000;
+
     std::atomic<float> value_{NAN};
 
-    /**
-     * Returns true if changed
-     */
-    bool set_value_(float value)
-    {
-        if (value_.exchange(value) != value)
-        {
-            return true;
-        }
-        return false;
-    }
-};
+    // only used by the writer
+    float notified_value_{NAN};
+    uint32_t notified_time_{0};
 
-template <uint16_t countT> class sensor_history_t
-{
-  public:
-    typedef struct
+    sensor_value_change set_value_(float value, const sensor_definition &definition, uint32_t now)
     {
-        float mean;
-        float min;
-        float max;
-    } stats;
-
-    using vector_history_t = std::vector<float, esp32::psram::allocator<float>>;
+        const auto previous = value_.exchange(value);
 
-    typedef struct
-    {
-        std::optional<stats> stat;
-        vector_history_t history;
-    } sensor_history_snapshot;
+        // a suppressed change is checked again with the next value, even if it is the same
+        if (!is_significant(value, definition, now))
+        {
+            return is_same(previous, value) ? sensor_value_change::none : sensor_value_change::suppressed;
+        }
 
-    void add_value(float value)
-    {
-        std::lock_guard<esp32::semaphore> lock(data_mutex_);
-        last_x_values_.push(value);
+        notified_value_ = value;
+        notified_time_ = now;
+        return sensor_value_change::notify;
     }
 
-    void clear()
+    static bool is_same(float value1, float value2)
     {
-        std::lock_guard<esp32::semaphore> lock(data_mutex_);
-        last_x_values_.clear();
+        return (value1 == value2) || (std::isnan(value1) && std::isnan(value2));
     }
 
-    sensor_history_snapshot get_snapshot(uint8_t group_by_count) const
+    bool is_significant(float value, const sensor_definition &definition, uint32_t now) const
     {
-        vector_history_t return_values;
-
-        std::lock_guard<esp32::semaphore> lock(data_mutex_);
-        const auto size = last_x_values_.size();
-        if (size)
+        if (std::isnan(value) || std::isnan(notified_value_))
         {
-            return_values.reserve(1 + (size / group_by_count));
-            float value_max = std::numeric_limits<float>::min();
-            float value_min = std::numeric_limits<float>::max();
-            double sum = 0;
-            double group_sum = 0;
-            for (auto i = 0; i < size; i++)
-            {
-                const auto value = last_x_values_[i];
-                sum += value;
-                group_sum += value;
-                value_max = std::max<float>(value, value_max);
-                value_min = std::min<float>(value, value_min);
-
-                if (((i + 1) % group_by_count) == 0)
-                {
-                    return_values.push_back(group_sum / (group_by_count));
-                    group_sum = 0;
-                }
-            }
-
-            // add partial group average
-            if (size % group_by_count)
-            {
-                return_values.push_back(group_sum / (size % group_by_count));
-            }
-
-            stats stats_value;
-            stats_value.max = value_max;
-            stats_value.min = value_min;
-            stats_value.mean = sum / size;
-            return {stats_value, return_values};
+            return std::isnan(value) != std::isnan(notified_value_);
         }
-        else
-        {
-            return {std::nullopt, return_values};
-        };
-    }
 
-    std::optional<float> get_average() const
-    {
-        std::lock_guard<esp32::semaphore> lock(data_mutex_);
-        const auto size = last_x_values_.size();
-        if (size)
+        if (value == notified_value_)
         {
-            double sum = 0;
-            for (auto i = 0; i < size; i++)
-            {
-                sum += last_x_values_[i];
-            }
-            return sum / size;
+            return false;
         }
-        else
+
+        const auto elapsed = now - notified_time_;
+        if (elapsed >= max_notify_interval_ms)
         {
-            return std::nullopt;
+            return true;
         }
-    }
 
-  private:
-    mutable esp32::semaphore data_mutex_;
-    circular_buffer<float, countT> last_x_values_;
+        return (elapsed >= definition.get_min_notify_interval_ms()) && definition.exceeds_notify_deadband(value, notified_value_);
+    }
 };
 
-template <uint8_t reads_per_minuteT, uint16_t minutesT> class sensor_history_minute_t : public sensor_history_t<reads_per_minuteT * minutesT>
+/**
+ * Data of SENSOR_VALUES_CHANGE, the notified values of one acquisition. Posted by value through the event loop.
+ */
+struct sensor_values_change
 {
-  public:
-    static constexpr auto total_minutes = minutesT;
-    static constexpr auto reads_per_minute = reads_per_minuteT;
-    static constexpr auto sensor_interval = (60u * 1000 / reads_per_minute);
-};
+    static_assert(total_sensors <= 32);
+
+    uint32_t changed{0}; // bit per sensor_id_index
+    std::array<float, total_sensors> values{};
 
-using sensor_history = sensor_history_minute_t<12, 360>;
+    void set(sensor_id_index index, float value)
+    {
+        changed |= BIT(static_cast<uint8_t>(index));
+        values[static_cast<size_t>(index)] = value;
+    }
+
+    bool has(sensor_id_index index) const
+    {
+        return changed & BIT(static_cast<uint8_t>(index));
+    }
+
+    float get(sensor_id_index index) const
+    {
+        return values[static_cast<size_t>(index)];
+    }
+};
 
 constexpr std::array<sensor_definition_display, 0> no_level{};
 
@@ -279,18 +261,18 @@ constexpr std::array<sensor_definition_display, 6> co2_definition_display{
 #endif
 
 constexpr std::array<sensor_definition, total_sensors> sensor_definitions{
-    sensor_definition{"PM 2.5", "µg/m³", pm_2_5_definition_display.data(), pm_2_5_definition_display.size(), 0, 1000, 1},
-    sensor_definition{"Temperature", "°F", no_level.data(), no_level.size(), -40, 140, 1},
-    sensor_definition{"Temperature", "°C", no_level.data(), no_level.size(), -40, 70, 0.1},
-    sensor_definition{"Humidity", "⁒", no_level.data(), no_level.size(), 0, 100, 1},
+    sensor_definition{"PM 2.5", "µg/m³", pm_2_5_definition_display.data(), pm_2_5_definition_display.size(), 0, 1000, 1, 2, 10000},
+    sensor_definition{"Temperature", "°F", no_level.data(), no_level.size(), -40, 140, 1, 1, 10000},
+    sensor_definition{"Temperature", "°C", no_level.data(), no_level.size(), -40, 70, 0.1, 2, 10000},
+    sensor_definition{"Humidity", "⁒", no_level.data(), no_level.size(), 0, 100, 1, 2, 10000},
 #if defined CONFIG_SCD30_SENSOR_ENABLE || defined CONFIG_SCD4x_SENSOR_ENABLE
-    sensor_definition{"CO2", "ppm", co2_definition_display.data(), co2_definition_display.size(), 0, 2000, 1},
+    sensor_definition{"CO2", "ppm", co2_definition_display.data(), co2_definition_display.size(), 0, 2000, 1, 10, 10000},
 #endif
-    sensor_definition{"PM 1", "µg/m³", no_level.data(), no_level.size(), 0, 1000, 1},
-    sensor_definition{"PM 4", "µg/m³", no_level.data(), no_level.size(), 0, 1000, 1},
-    sensor_definition{"PM 10", "µg/m³", pm_10_definition_display.data(), pm_10_definition_display.size(), 0, 1000, 1},
-    sensor_definition{"Typical Particle Size", "µg", no_level.data(), no_level.size(), 0, 10, 0.1},
-    sensor_definition{"Light Intensity", "lux", no_level.data(), no_level.size(), 0, 65535, 1},
+    sensor_definition{"PM 1", "µg/m³", no_level.data(), no_level.size(), 0, 1000, 1, 2, 10000},
+    sensor_definition{"PM 4", "µg/m³", no_level.data(), no_level.size(), 0, 1000, 1, 2, 10000},
+    sensor_definition{"PM 10", "µg/m³", pm_10_definition_display.data(), pm_10_definition_display.size(), 0, 1000, 1, 2, 10000},
+    sensor_definition{"Typical Particle Size", "µg", no_level.data(), no_level.size(), 0, 10, 0.1, 2, 10000},
+    sensor_definition{"Light Intensity", "lux", no_level.data(), no_level.size(), 0, 65535, 1, 5, 5000},
 };
 
 constexpr auto &&get_sensor_definition(sensor_id_index id)
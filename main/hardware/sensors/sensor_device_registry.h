@@ -0,0 +1,55 @@
+#pragma once
+
+#include "hardware/sensors/bh1750_sensor_device.h"
+#include "hardware/sensors/replay_sensor_device.h"
+#include "hardware/sensors/scd30_sensor_device.h"
+#include "hardware/sensors/scd4x_sensor_device.h"
+#include "hardware/sensors/sht3x_sensor_device.h"
+#include "hardware/sensors/sps30_sensor_device.h"
+#include "sdkconfig.h"
+#include <stdint.h>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * Compile time list of sensor device singletons. hardware initializes, schedules and reads every device
+ * in the list through fold expressions, so a device which is not listed is not compiled in.
+ * Only the devices are listed here, the channels they report are not generated from it. A device with a new
+ * kind of value also needs its sensor_id_index, its sensor_definitions entry, its HomeKit definition and
+ * the screens showing it, each under the device's #ifdef. Their order is part of the web, HomeKit and
+ * stored history data.
+ */
+template <class... Ts> struct sensor_device_list
+{
+    static constexpr uint8_t size = sizeof...(Ts);
+
+    template <class T> static constexpr bool contains = (std::is_same_v<T, Ts> || ...);
+
+    using references = std::tuple<Ts &...>;
+
+    // a `T<device>` for every device, in the same order
+    template <template <class> class T> using transform = std::tuple<T<Ts>...>;
+
+    static references create_instances()
+    {
+        return {Ts::create_instance()...};
+    }
+};
+
+// A device is one line here, plus hardware::prepare_read or read_device overloads if it needs more than read_sensor
+using sensor_devices = sensor_device_list<
+#ifdef CONFIG_SHT3X_SENSOR_ENABLE
+    sht3x_sensor_device,
+#endif
+#ifdef CONFIG_SCD30_SENSOR_ENABLE
+    scd30_sensor_device,
+#endif
+#ifdef CONFIG_SCD4x_SENSOR_ENABLE
+    scd4x_sensor_device,
+#endif
+#ifdef CONFIG_SENSOR_REPLAY_ENABLE
+    replay_sensor_device, // replaces the SPS30 readings
+#else
+    sps30_sensor_device,
+#endif
+    bh1750_sensor_device>;
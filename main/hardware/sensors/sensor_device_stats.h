@@ -0,0 +1,159 @@
+#pragma once
+
+#include "util/metrics.h"
+#include "util/misc.h"
+#include "util/noncopyable.h"
+#include <array>
+#include <atomic>
+#include <esp_err.h>
+#include <stdint.h>
+
+// read and transfer latencies in microseconds, the last bucket counts everything slower
+using latency_histogram = esp32::metrics::histogram<500, 1000, 2000, 5000, 10000, 20000, 50000, 100000>;
+
+/**
+ * Acquisition counters of a sensor device. Written by the i2c bus and sensor tasks, read lock free from any task,
+ * so counters read together can be off by one update. hardware reports them for the devices in sensor_devices.
+ */
+class sensor_device_stats : esp32::noncopyable
+{
+  public:
+    explicit sensor_device_stats(const char *name) : name_(name)
+    {
+    }
+
+    /**
+     * A read of the device, `fresh` if it returned a new measurement
+     */
+    void record_read(uint32_t latency_us, bool fresh, uint8_t nan_values)
+    {
+        read_latency_.add(latency_us);
+        (fresh ? reads_ : not_ready_).add();
+        if (nan_values)
+        {
+            nan_values_.add(nan_values);
+        }
+    }
+
+    void record_error(esp_err_t error)
+    {
+        errors_.add();
+        last_error_.store(error, std::memory_order_relaxed);
+        last_error_time_.store(esp32::millis(), std::memory_order_relaxed);
+    }
+
+    /**
+     * The read did not finish within its i2c bus timeout
+     */
+    void record_timeout()
+    {
+        timeouts_.add();
+    }
+
+    /**
+     * A read has been running on the bus for longer than it should, the device is unhealthy until it finishes
+     */
+    void record_stall()
+    {
+        stalls_.add();
+        healthy_.store(false, std::memory_order_relaxed);
+    }
+
+    void record_recovery()
+    {
+        healthy_.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * A single i2c transfer, only available for devices whose driver goes through our glue code
+     */
+    void record_transfer(uint32_t latency_us, esp_err_t error)
+    {
+        transfer_latency_.add(latency_us);
+        if (error != ESP_OK)
+        {
+            transfer_errors_.add();
+            record_error(error);
+        }
+    }
+
+    const char *get_name() const
+    {
+        return name_;
+    }
+
+    uint32_t get_reads() const
+    {
+        return reads_.get();
+    }
+
+    uint32_t get_not_ready() const
+    {
+        return not_ready_.get();
+    }
+
+    uint32_t get_errors() const
+    {
+        return errors_.get();
+    }
+
+    uint32_t get_nan_values() const
+    {
+        return nan_values_.get();
+    }
+
+    uint32_t get_timeouts() const
+    {
+        return timeouts_.get();
+    }
+
+    uint32_t get_stalls() const
+    {
+        return stalls_.get();
+    }
+
+    bool is_healthy() const
+    {
+        return healthy_.load(std::memory_order_relaxed);
+    }
+
+    uint32_t get_transfer_errors() const
+    {
+        return transfer_errors_.get();
+    }
+
+    esp_err_t get_last_error() const
+    {
+        return last_error_.load(std::memory_order_relaxed);
+    }
+
+    uint32_t get_last_error_time() const
+    {
+        return last_error_time_.load(std::memory_order_relaxed);
+    }
+
+    const latency_histogram &get_read_latency() const
+    {
+        return read_latency_;
+    }
+
+    const latency_histogram &get_transfer_latency() const
+    {
+        return transfer_latency_;
+    }
+
+  private:
+    const char *const name_;
+    esp32::metrics::counter reads_;
+    esp32::metrics::counter not_ready_;
+    esp32::metrics::counter errors_;
+    esp32::metrics::counter nan_values_;
+    esp32::metrics::counter timeouts_;
+    esp32::metrics::counter transfer_errors_;
+    esp32::metrics::counter stalls_;
+    std::atomic_bool healthy_{true};
+    std::atomic<esp_err_t> last_error_{ESP_OK};
+    std::atomic_uint32_t last_error_time_{0};
+    latency_histogram read_latency_;
+    latency_histogram transfer_latency_;
+};
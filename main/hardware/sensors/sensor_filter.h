@@ -0,0 +1,256 @@
+#pragma once
+
+#include "hardware/sensors/sensor_id.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdint.h>
+#include <tuple>
+#include <utility>
+
+/**
+ * Filters are plain classes with `float operator()(float value, uint32_t time)` and `reset()`, chained at compile time
+ * so there is no virtual dispatch per value. Inputs are never NaN, the chain handles invalid values.
+ * `time` is the esp32::millis() the value was measured at. Devices are read at a rate which changes with the signal,
+ * so filters which smooth or limit over time scale by the time since the previous value instead of per value.
+ */
+
+/**
+ * Rolling median of the last `countT` values, rejects spikes shorter than half the window
+ */
+template <uint8_t countT>
+    requires(countT % 2 == 1)
+class median_filter
+{
+  public:
+    float operator()(float value, uint32_t)
+    {
+        values_[next_] = value;
+        next_ = (next_ + 1) % countT;
+        size_ = std::min<uint8_t>(size_ + 1, countT);
+
+        auto sorted = values_;
+        std::sort(sorted.begin(), sorted.begin() + size_);
+        return sorted[(size_ - 1) / 2]; // lower median until the window fills
+    }
+
+    void reset()
+    {
+        next_ = 0;
+        size_ = 0;
+    }
+
+  private:
+    std::array<float, countT> values_{};
+    uint8_t next_{0};
+    uint8_t size_{0};
+};
+
+/**
+ * Exponential moving average, `alpha_percentT` is the weight of a value `interval_msT` after the previous one.
+ * Values further apart weigh more, so the average follows a change in the same time at any read rate.
+ */
+template <uint8_t alpha_percentT, uint32_t interval_msT>
+    requires(alpha_percentT > 0 && alpha_percentT <= 100 && interval_msT > 0)
+class ema_filter
+{
+  public:
+    float operator()(float value, uint32_t time)
+    {
+        if (std::isnan(average_))
+        {
+            average_ = value;
+        }
+        else
+        {
+            // the weight of the average decays by (1 - alpha) every interval
+            const auto intervals = static_cast<float>(time - last_time_) / interval_msT;
+            average_ += (value - average_) * (1 - std::pow(1 - alpha_percentT / 100.0f, intervals));
+        }
+        last_time_ = time;
+        return average_;
+    }
+
+    void reset()
+    {
+        average_ = NAN;
+    }
+
+  private:
+    float average_{NAN};
+    uint32_t last_time_{0};
+};
+
+/**
+ * Limits the change to `max_changeT` units per `interval_msT`
+ */
+template <uint32_t max_changeT, uint32_t interval_msT>
+    requires(interval_msT > 0)
+class rate_limit_filter
+{
+  public:
+    float operator()(float value, uint32_t time)
+    {
+        if (std::isnan(last_))
+        {
+            last_ = value;
+        }
+        else
+        {
+            const auto max_change = static_cast<float>(max_changeT) * (time - last_time_) / interval_msT;
+            last_ = std::clamp<float>(value, last_ - max_change, last_ + max_change);
+        }
+        last_time_ = time;
+        return last_;
+    }
+
+    void reset()
+    {
+        last_ = NAN;
+    }
+
+  private:
+    float last_{NAN};
+    uint32_t last_time_{0};
+};
+
+/**
+ * Rounds to `decimalsT` decimals, same as the device drivers, so that filtered values do not change on noise
+ */
+template <uint8_t decimalsT> class round_filter
+{
+  public:
+    float operator()(float value, uint32_t)
+    {
+        return std::round(value * scale) / scale;
+    }
+
+    void reset()
+    {
+    }
+
+  private:
+    static constexpr float scale = [] {
+        float value = 1;
+        for (auto i = 0; i < decimalsT; i++)
+        {
+            value *= 10;
+        }
+        return value;
+    }();
+};
+
+template <class... FiltersT> class filter_chain
+{
+  public:
+    /**
+     * NaN resets the chain and is passed through
+     */
+    float operator()(float value, uint32_t time)
+    {
+        if (std::isnan(value))
+        {
+            reset();
+            return value;
+        }
+
+        std::apply([&value, time](auto &...filter) { ((value = filter(value, time)), ...); }, filters_);
+        return value;
+    }
+
+    void reset()
+    {
+        std::apply([](auto &...filter) { (filter.reset(), ...); }, filters_);
+    }
+
+  private:
+    std::tuple<FiltersT...> filters_;
+};
+
+/**
+ * Filter chain used for each sensor, no filtering unless specialized
+ */
+template <sensor_id_index idT> struct sensor_filter_chain
+{
+    using type = filter_chain<>;
+};
+
+// smoothing is tuned for a value every 5 seconds, the fixed read rate the filters were first used at
+constexpr uint32_t filter_interval_ms = 5000;
+
+using particle_filter_chain = filter_chain<median_filter<3>, ema_filter<50, filter_interval_ms>, round_filter<0>>;
+
+template <> struct sensor_filter_chain<sensor_id_index::pm_1>
+{
+    using type = particle_filter_chain;
+};
+
+template <> struct sensor_filter_chain<sensor_id_index::pm_2_5>
+{
+    using type = particle_filter_chain;
+};
+
+template <> struct sensor_filter_chain<sensor_id_index::pm_4>
+{
+    using type = particle_filter_chain;
+};
+
+template <> struct sensor_filter_chain<sensor_id_index::pm_10>
+{
+    using type = particle_filter_chain;
+};
+
+template <> struct sensor_filter_chain<sensor_id_index::typical_particle_size>
+{
+    using type = filter_chain<median_filter<3>, ema_filter<50, filter_interval_ms>, round_filter<1>>;
+};
+
+#if defined CONFIG_SCD30_SENSOR_ENABLE || defined CONFIG_SCD4x_SENSOR_ENABLE
+// breathing near the sensor gives short spikes of thousands of ppm, it measures every 30 seconds
+template <> struct sensor_filter_chain<sensor_id_index::CO2>
+{
+    using type = filter_chain<median_filter<3>, rate_limit_filter<100, 30 * 1000>>;
+};
+#endif
+
+template <> struct sensor_filter_chain<sensor_id_index::temperatureC>
+{
+    using type = filter_chain<ema_filter<50, filter_interval_ms>, round_filter<2>>;
+};
+
+template <> struct sensor_filter_chain<sensor_id_index::temperatureF>
+{
+    using type = filter_chain<ema_filter<50, filter_interval_ms>, round_filter<1>>;
+};
+
+template <> struct sensor_filter_chain<sensor_id_index::humidity>
+{
+    using type = filter_chain<ema_filter<50, filter_interval_ms>, round_filter<0>>;
+};
+
+/**
+ * Filter chains of all sensors, dispatched on the sensor index without virtual calls. Not thread safe.
+ */
+class sensor_filters
+{
+  public:
+    float apply(sensor_id_index index, float value, uint32_t time)
+    {
+        return apply(static_cast<size_t>(index), value, time, std::make_index_sequence<total_sensors>{});
+    }
+
+  private:
+    template <class> struct chains;
+    template <size_t... I> struct chains<std::index_sequence<I...>>
+    {
+        using type = std::tuple<typename sensor_filter_chain<static_cast<sensor_id_index>(I)>::type...>;
+    };
+
+    typename chains<std::make_index_sequence<total_sensors>>::type chains_;
+
+    template <size_t... I> float apply(size_t index, float value, uint32_t time, std::index_sequence<I...>)
+    {
+        ((index == I ? (value = std::get<I>(chains_)(value, time), true) : false) || ...);
+        return value;
+    }
+};
@@ -0,0 +1,800 @@
+#pragma once
+
+#include "util/binary_io.h"
+#include "util/circular_buffer.h"
+#include "util/compressed_float_ring.h"
+#include "util/p_square_quantile.h"
+#include "util/psram_allocator.h"
+#include "util/semaphore_lockable.h"
+#include "util/seqlock.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+typedef struct
+{
+    float mean;
+    float min;
+    float max;
+} sensor_history_stats;
+
+typedef struct
+{
+    float p50;
+    float p95;
+    float p99;
+} sensor_history_percentiles;
+
+/**
+ * Accumulates mean/min/max of a set of values or of already rolled up buckets. NaN values and buckets are gaps
+ * and are skipped.
+ */
+class sensor_history_stats_accumulator
+{
+  public:
+    void add(float value)
+    {
+        add({value, value, value}, 1);
+    }
+
+    void add(const sensor_history_stats &value, float weight)
+    {
+        if (std::isnan(value.mean))
+        {
+            return;
+        }
+
+        if (weight_ == 0)
+        {
+            min_ = value.min;
+            max_ = value.max;
+        }
+        else
+        {
+            min_ = std::min(min_, value.min);
+            max_ = std::max(max_, value.max);
+        }
+        sum_ += static_cast<double>(value.mean) * weight;
+        weight_ += weight;
+    }
+
+    std::optional<sensor_history_stats> get() const
+    {
+        if (weight_ > 0)
+        {
+            return sensor_history_stats{static_cast<float>(sum_ / weight_), min_, max_};
+        }
+        return std::nullopt;
+    }
+
+    void clear()
+    {
+        sum_ = 0;
+        weight_ = 0;
+    }
+
+  private:
+    double sum_{0};
+    double weight_{0};
+    float min_{};
+    float max_{};
+};
+
+/**
+ * Fixed window of raw values with running sum and monotonic min/max candidate queues so that
+ * stats are O(1). NaN values are gaps, they take a place in the window but not in the stats. Not thread safe.
+ */
+template <uint16_t countT> class sensor_value_window_t
+{
+  public:
+    static constexpr uint16_t capacity = countT;
+
+    void add_value(float value)
+    {
+        if (values_.is_full())
+        {
+            // drop the oldest value from the running stats before it is overwritten
+            const uint16_t oldest_sequence = next_sequence_ - values_.size();
+            const auto oldest = values_.first();
+            if (!std::isnan(oldest))
+            {
+                sum_ -= oldest;
+                valid_count_--;
+            }
+            if (!min_candidates_.isEmpty() && min_candidates_.first() == oldest_sequence)
+            {
+                min_candidates_.shift();
+            }
+            if (!max_candidates_.isEmpty() && max_candidates_.first() == oldest_sequence)
+            {
+                max_candidates_.shift();
+            }
+        }
+
+        values_.push(value);
+        const uint16_t sequence = next_sequence_++;
+        if (std::isnan(value))
+        {
+            return;
+        }
+
+        sum_ += value;
+        valid_count_++;
+
+        // candidates are kept monotonic so the front is always the window min/max
+        while (!min_candidates_.isEmpty() && value_at_sequence(min_candidates_.last()) >= value)
+        {
+            min_candidates_.pop();
+        }
+        while (!max_candidates_.isEmpty() && value_at_sequence(max_candidates_.last()) <= value)
+        {
+            max_candidates_.pop();
+        }
+
+        min_candidates_.push(sequence);
+        max_candidates_.push(sequence);
+    }
+
+    void clear()
+    {
+        values_.clear();
+        min_candidates_.clear();
+        max_candidates_.clear();
+        sum_ = 0;
+        valid_count_ = 0;
+    }
+
+    uint16_t size() const
+    {
+        return values_.size();
+    }
+
+    float operator[](uint16_t index) const
+    {
+        return values_[index];
+    }
+
+    /**
+     * Copies the newest `count` values, oldest first, and returns how many were copied
+     */
+    uint16_t copy_newest(uint16_t count, float *destination) const
+    {
+        const uint16_t size = values_.size();
+        count = std::min(count, size);
+        return values_.copy_to(destination, size - count, count);
+    }
+
+    std::optional<sensor_history_stats> get_stats() const
+    {
+        const auto size = valid_count_;
+        if (size)
+        {
+            sensor_history_stats stats_value;
+            stats_value.max = value_at_sequence(max_candidates_.first());
+            stats_value.min = value_at_sequence(min_candidates_.first());
+            stats_value.mean = sum_ / size;
+            return stats_value;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<float> get_average() const
+    {
+        const auto size = valid_count_;
+        if (size)
+        {
+            return sum_ / size;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    template <class S> bool save(S &stream) const
+    {
+        return esp32::binary_io::write_buffer(stream, values_);
+    }
+
+    /**
+     * Values are re-added so that running stats are rebuilt
+     */
+    template <class S> bool load(S &stream)
+    {
+        clear();
+        typename decltype(values_)::index_t size;
+        if (!esp32::binary_io::read(stream, size) || size > countT)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < size; i++)
+        {
+            float value;
+            if (!esp32::binary_io::read(stream, value))
+            {
+                clear();
+                return false;
+            }
+            add_value(value);
+        }
+        return true;
+    }
+
+  private:
+    circular_buffer<float, countT> values_;
+    double sum_{0};
+    uint16_t valid_count_{0};
+    uint16_t next_sequence_{0}; // wraps, window is always smaller than 2^16
+    circular_buffer<uint16_t, countT> min_candidates_;
+    circular_buffer<uint16_t, countT> max_candidates_;
+
+    float value_at_sequence(uint16_t sequence) const
+    {
+        const uint16_t age = next_sequence_ - sequence;
+        return values_[values_.size() - age];
+    }
+};
+
+/**
+ * Streaming P50/P95/P99 of about the last `window_countT` values without keeping them. Two generations of
+ * P² estimators are restarted half a window apart and the older one is reported, so the estimate always
+ * covers between half and the full window. Not thread safe.
+ */
+template <uint32_t window_countT> class sensor_history_percentiles_t
+{
+  public:
+    void add_value(float value)
+    {
+        for (auto &&generation : generations_)
+        {
+            for (auto &&estimator : generation)
+            {
+                estimator.add(value);
+            }
+        }
+
+        if (++added_ == window_countT / 2)
+        {
+            added_ = 0;
+            for (auto &&estimator : generations_[get_oldest()])
+            {
+                estimator.clear();
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (auto &&generation : generations_)
+        {
+            for (auto &&estimator : generation)
+            {
+                estimator.clear();
+            }
+        }
+        added_ = 0;
+    }
+
+    std::optional<sensor_history_percentiles> get() const
+    {
+        const auto &generation = generations_[get_oldest()];
+        const auto p50 = generation[0].get();
+        const auto p95 = generation[1].get();
+        const auto p99 = generation[2].get();
+        if (p50.has_value() && p95.has_value() && p99.has_value())
+        {
+            return sensor_history_percentiles{p50.value(), p95.value(), p99.value()};
+        }
+        return std::nullopt;
+    }
+
+    template <class S> bool save(S &stream) const
+    {
+        using namespace esp32::binary_io;
+        return write(stream, generations_) && write(stream, added_);
+    }
+
+    template <class S> bool load(S &stream)
+    {
+        using namespace esp32::binary_io;
+        if (read(stream, generations_) && read(stream, added_) && added_ < window_countT / 2)
+        {
+            return true;
+        }
+        clear();
+        return false;
+    }
+
+  private:
+    using generation_t = std::array<p_square_quantile, 3>;
+
+    std::array<generation_t, 2> generations_{create_generation(), create_generation()};
+    uint32_t added_{0};
+
+    static generation_t create_generation()
+    {
+        return {p_square_quantile{0.5f}, p_square_quantile{0.95f}, p_square_quantile{0.99f}};
+    }
+
+    uint8_t get_oldest() const
+    {
+        return generations_[0][0].count() >= generations_[1][0].count() ? 0 : 1;
+    }
+};
+
+/**
+ * Ring of rolled up buckets, each bucket folds `group_countT` entries of the finer tier. A bucket without
+ * values is a gap, its stats are NaN. Not thread safe.
+ */
+template <uint16_t countT, uint16_t group_countT> class sensor_history_rollup_tier_t
+{
+  public:
+    static constexpr uint16_t capacity = countT;
+    static constexpr uint16_t group_count = group_countT;
+    static constexpr sensor_history_stats gap{NAN, NAN, NAN};
+
+    /**
+     * Returns the bucket if this value completed it
+     */
+    std::optional<sensor_history_stats> add(const sensor_history_stats &value)
+    {
+        pending_.add(value, 1);
+        if (++pending_count_ == group_countT)
+        {
+            return complete_pending();
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * Adds `count` gap entries. Returns the in-progress bucket if they completed it, followed by
+     * the number of gap buckets completed after it.
+     */
+    std::pair<std::optional<sensor_history_stats>, uint32_t> add_gap(uint32_t count)
+    {
+        std::optional<sensor_history_stats> bucket;
+        if (pending_count_)
+        {
+            const auto filled = std::min<uint32_t>(count, group_countT - pending_count_);
+            count -= filled;
+            pending_count_ += filled;
+            if (pending_count_ < group_countT)
+            {
+                return {bucket, 0};
+            }
+            bucket = complete_pending();
+        }
+
+        // older gap buckets would be overwritten anyway
+        const auto gaps = count / group_countT;
+        for (uint32_t i = 0; i < std::min<uint32_t>(gaps, countT); i++)
+        {
+            values_.push(gap);
+        }
+        pending_count_ = count % group_countT;
+        return {bucket, gaps};
+    }
+
+    void clear()
+    {
+        values_.clear();
+        pending_.clear();
+        pending_count_ = 0;
+    }
+
+    /**
+     * Entries folded into the in-progress bucket
+     */
+    uint16_t pending_count() const
+    {
+        return pending_count_;
+    }
+
+    /**
+     * Entries of the finer tier held by the complete and the in-progress buckets
+     */
+    uint32_t covered_count() const
+    {
+        return values_.size() * group_countT + pending_count_;
+    }
+
+    /**
+     * Appends the newest `count` buckets, the last one being the in-progress bucket if any
+     */
+    template <class V> void append_newest(uint16_t count, V &history, sensor_history_stats_accumulator &stats) const
+    {
+        const uint16_t pending = pending_count_ ? 1 : 0;
+        const uint16_t complete = std::min<uint16_t>(values_.size(), count > pending ? count - pending : 0);
+
+        const auto end = values_.end();
+        for (auto iterator = end - complete; iterator != end; ++iterator)
+        {
+            history.push_back(iterator->mean);
+            stats.add(*iterator, 1);
+        }
+
+        // may be read while being written under a seqlock, so do not assume the bucket is valid
+        const auto value = pending_.get();
+        if (pending)
+        {
+            history.push_back(value.value_or(gap).mean);
+            stats.add(value.value_or(gap), static_cast<float>(pending_count_) / group_countT);
+        }
+    }
+
+    template <class S> bool save(S &stream) const
+    {
+        using namespace esp32::binary_io;
+        return write_buffer(stream, values_) && write(stream, pending_) && write(stream, pending_count_);
+    }
+
+    template <class S> bool load(S &stream)
+    {
+        using namespace esp32::binary_io;
+        if (read_buffer(stream, values_) && read(stream, pending_) && read(stream, pending_count_) && pending_count_ < group_countT)
+        {
+            return true;
+        }
+        clear();
+        return false;
+    }
+
+  private:
+    circular_buffer<sensor_history_stats, countT> values_;
+    sensor_history_stats_accumulator pending_;
+    uint16_t pending_count_{0};
+
+    sensor_history_stats complete_pending()
+    {
+        const auto bucket = pending_.get().value_or(gap);
+        values_.push(bucket);
+        pending_.clear();
+        pending_count_ = 0;
+        return bucket;
+    }
+};
+
+/**
+ * Sensor history with raw values for the last hour and mean/min/max rollups of 1 minute for 24 hours,
+ * 15 minutes for 7 days and 1 hour for 90 days. Rollups are folded in as values are added.
+ * All values are also kept at full resolution in a compressed ring, which covers days for slow
+ * changing sensors. It serves snapshots of more than an hour at full resolution, up to
+ * max_full_resolution_points.
+ * Intervals without values, like the time the device was off, are gaps which show as NaN points.
+ * Values are added by a single writer, readers use a seqlock and never block it.
+ */
+template <uint8_t reads_per_minuteT> class sensor_history_tiered_t
+{
+  public:
+    using stats = sensor_history_stats;
+    using vector_history_t = std::vector<float, esp32::psram::allocator<float>>;
+
+    typedef struct
+    {
+        std::optional<stats> stat;
+        std::optional<sensor_history_percentiles> percentiles; // of the last 12 to 24 hours, not of the range
+        vector_history_t history;
+        uint32_t interval_seconds; // time between history points
+
+        // values are numbered by the count added since boot, restored values have negative numbers
+        uint32_t value_count;   // values added when the snapshot was taken
+        uint32_t valid_since;   // value_count when the history was last cleared or loaded
+        int64_t start;          // number of the first value of the first point
+        uint32_t values_per_point;
+    } sensor_history_snapshot;
+
+    using snapshot_handle = std::shared_ptr<const sensor_history_snapshot>;
+
+    static constexpr auto reads_per_minute = reads_per_minuteT;
+    static constexpr auto sensor_interval = (60u * 1000 / reads_per_minute);
+
+    static constexpr uint32_t default_range_seconds = 6 * 60 * 60;
+    static constexpr uint16_t default_max_points = 360;
+    static constexpr uint16_t max_full_resolution_points = 12 * 60 * reads_per_minute; // 12 hours
+
+    /**
+     * Sets the precision of the sensor values, used for compressing full resolution values
+     */
+    void set_value_step(float value_step)
+    {
+        std::lock_guard<esp32::seqlock> lock(data_lock_);
+        // sensors round to a tenth of their display step
+        full_resolution_.set_quantization_step(value_step / 10);
+    }
+
+    /**
+     * Adds the value for `count` consecutive intervals in a single write
+     */
+    void add_value(float value, uint16_t count = 1)
+    {
+        std::lock_guard<esp32::seqlock> lock(data_lock_);
+        for (uint16_t i = 0; i < count; i++)
+        {
+            add_value_(value);
+        }
+    }
+
+    /**
+     * Adds `count` intervals without values in a single write
+     */
+    void add_gap(uint32_t count)
+    {
+        std::lock_guard<esp32::seqlock> lock(data_lock_);
+        value_count_ += count;
+        for (uint32_t i = 0; i < std::min<uint32_t>(count, raw_count); i++)
+        {
+            raw_.add_value(NAN);
+        }
+        full_resolution_.push(NAN, count);
+
+        // a minute completed by the gap may still hold values, the buckets after it are gaps
+        const auto [minute, minute_gaps] = minute_.add_gap(count);
+        if (minute.has_value())
+        {
+            const auto quarter_hour = quarter_hour_.add(minute.value());
+            if (quarter_hour.has_value())
+            {
+                hour_.add(quarter_hour.value());
+            }
+        }
+
+        const auto [quarter_hour, quarter_hour_gaps] = quarter_hour_.add_gap(minute_gaps);
+        if (quarter_hour.has_value())
+        {
+            hour_.add(quarter_hour.value());
+        }
+        hour_.add_gap(quarter_hour_gaps);
+    }
+
+    void clear()
+    {
+        std::lock_guard<esp32::seqlock> lock(data_lock_);
+        raw_.clear();
+        full_resolution_.clear();
+        percentiles_.clear();
+        minute_.clear();
+        quarter_hour_.clear();
+        hour_.clear();
+        valid_since_ = value_count_;
+    }
+
+    /**
+     * Stats of the raw values, O(1)
+     */
+    std::optional<stats> get_stats() const
+    {
+        return data_lock_.read([this] { return raw_.get_stats(); });
+    }
+
+    std::optional<float> get_average() const
+    {
+        return data_lock_.read([this] { return raw_.get_average(); });
+    }
+
+    /**
+     * Appends the serialized history to `buffer` without blocking the writer, a write meanwhile restarts it.
+     * Returns the write_count() the copy was taken at.
+     */
+    template <class A> uint32_t save(std::vector<uint8_t, A> &buffer) const
+    {
+        const auto size = buffer.size();
+        return data_lock_.read([&] {
+            buffer.resize(size);
+            esp32::binary_io::memory_writer writer(buffer);
+            // writing to memory does not fail
+            raw_.save(writer);
+            full_resolution_.save(writer);
+            percentiles_.save(writer);
+            minute_.save(writer);
+            quarter_hour_.save(writer);
+            hour_.save(writer);
+            return data_lock_.sequence() / 2;
+        });
+    }
+
+    /**
+     * Number of writes to the history, every add_value(), add_gap(), clear() or load() call is one
+     */
+    uint32_t write_count() const
+    {
+        return data_lock_.sequence() / 2;
+    }
+
+    /**
+     * Either everything is loaded or the history is left empty
+     */
+    template <class S> bool load(S &stream)
+    {
+        std::lock_guard<esp32::seqlock> lock(data_lock_);
+        valid_since_ = value_count_;
+        if (raw_.load(stream) && full_resolution_.load(stream) && percentiles_.load(stream) && minute_.load(stream) && quarter_hour_.load(stream) &&
+            hour_.load(stream))
+        {
+            return true;
+        }
+
+        raw_.clear();
+        full_resolution_.clear();
+        percentiles_.clear();
+        minute_.clear();
+        quarter_hour_.clear();
+        hour_.clear();
+        return false;
+    }
+
+    /**
+     * Picks the finest tier which covers `range_seconds` within `max_points`. Ranges longer than the raw hour
+     * come from the full resolution ring if `max_points` allows it and the ring holds at least as much of the
+     * range as the minute tier.
+     */
+    sensor_history_snapshot get_snapshot(uint32_t range_seconds, uint16_t max_points) const
+    {
+        const auto points_for = [range_seconds](uint32_t interval) { return std::max<uint32_t>(1, (range_seconds + interval - 1) / interval); };
+        const auto fits = [&](uint32_t interval, uint16_t capacity) {
+            const auto points = points_for(interval);
+            return points <= capacity && points <= max_points;
+        };
+
+        return data_lock_.read([&] {
+            sensor_history_snapshot snapshot;
+            sensor_history_stats_accumulator stats_accumulator;
+
+            // values after the last complete point, shown as the last point if its tier has an in-progress bucket
+            uint32_t pending_values = 0;
+            bool pending_shown = false;
+
+            if (fits(raw_interval_seconds, raw_count))
+            {
+                snapshot.interval_seconds = raw_interval_seconds;
+                snapshot.history.resize(std::min<uint32_t>(raw_count, points_for(raw_interval_seconds)));
+                snapshot.history.resize(raw_.copy_newest(snapshot.history.size(), snapshot.history.data()));
+                for (const auto value : snapshot.history)
+                {
+                    stats_accumulator.add(value);
+                }
+            }
+            else if ((points_for(raw_interval_seconds) <= std::min<uint32_t>(max_points, max_full_resolution_points)) &&
+                     (full_resolution_.size() >= std::min<uint32_t>(points_for(raw_interval_seconds), minute_.covered_count())))
+            {
+                snapshot.interval_seconds = raw_interval_seconds;
+                const auto count = std::min<size_t>(points_for(raw_interval_seconds), full_resolution_.size());
+                snapshot.history.reserve(count);
+                full_resolution_.for_each_newest(count, [&](float value) {
+                    snapshot.history.push_back(value);
+                    stats_accumulator.add(value);
+                });
+            }
+            else if (fits(minute_interval_seconds, minute_tier_t::capacity))
+            {
+                append_tier(minute_, minute_interval_seconds, points_for(minute_interval_seconds), snapshot, stats_accumulator);
+                pending_values = minute_.pending_count();
+                pending_shown = minute_.pending_count();
+            }
+            else if (fits(quarter_hour_interval_seconds, quarter_hour_tier_t::capacity))
+            {
+                append_tier(quarter_hour_, quarter_hour_interval_seconds, points_for(quarter_hour_interval_seconds), snapshot, stats_accumulator);
+                pending_values = quarter_hour_.pending_count() * minute_tier_t::group_count + minute_.pending_count();
+                pending_shown = quarter_hour_.pending_count();
+            }
+            else
+            {
+                const auto points = std::min<uint32_t>({points_for(hour_interval_seconds), hour_tier_t::capacity, max_points});
+                append_tier(hour_, hour_interval_seconds, points, snapshot, stats_accumulator);
+                pending_values = (hour_.pending_count() * quarter_hour_tier_t::group_count + quarter_hour_.pending_count()) * minute_tier_t::group_count +
+                                 minute_.pending_count();
+                pending_shown = hour_.pending_count();
+            }
+
+            snapshot.value_count = value_count_;
+            snapshot.valid_since = valid_since_;
+            snapshot.values_per_point = snapshot.interval_seconds / raw_interval_seconds;
+            const auto complete_points = static_cast<int64_t>(snapshot.history.size()) - (pending_shown ? 1 : 0);
+            snapshot.start = static_cast<int64_t>(value_count_) - pending_values - complete_points * snapshot.values_per_point;
+
+            snapshot.stat = stats_accumulator.get();
+            snapshot.percentiles = percentiles_.get();
+            return snapshot;
+        });
+    }
+
+    /**
+     * Same as get_snapshot() but the snapshot is built once and shared by all readers until the next write
+     */
+    snapshot_handle get_shared_snapshot(uint32_t range_seconds, uint16_t max_points) const
+    {
+        // a snapshot built while a write happens is tagged with the older sequence, so it is never matched
+        const auto sequence = data_lock_.sequence();
+        {
+            std::lock_guard<esp32::semaphore> lock(snapshot_cache_mutex_);
+            for (auto &&entry : snapshot_cache_)
+            {
+                if (entry.snapshot && entry.sequence == sequence && entry.range_seconds == range_seconds && entry.max_points == max_points)
+                {
+                    return entry.snapshot;
+                }
+            }
+        }
+
+        snapshot_handle snapshot = std::allocate_shared<sensor_history_snapshot>(esp32::psram::allocator<sensor_history_snapshot>(),
+                                                                                 get_snapshot(range_seconds, max_points));
+
+        std::lock_guard<esp32::semaphore> lock(snapshot_cache_mutex_);
+        auto &entry = snapshot_cache_[next_snapshot_cache_entry_];
+        next_snapshot_cache_entry_ = (next_snapshot_cache_entry_ + 1) % snapshot_cache_.size();
+        entry = {range_seconds, max_points, sequence, snapshot};
+        return snapshot;
+    }
+
+  private:
+    static constexpr uint16_t raw_count = 60 * reads_per_minute;
+    using minute_tier_t = sensor_history_rollup_tier_t<24 * 60, reads_per_minute>;
+    using quarter_hour_tier_t = sensor_history_rollup_tier_t<7 * 24 * 4, 15>;
+    using hour_tier_t = sensor_history_rollup_tier_t<90 * 24, 4>;
+
+    static constexpr uint32_t raw_interval_seconds = sensor_interval / 1000;
+    static constexpr uint32_t minute_interval_seconds = raw_interval_seconds * minute_tier_t::group_count;
+    static constexpr uint32_t quarter_hour_interval_seconds = minute_interval_seconds * quarter_hour_tier_t::group_count;
+    static constexpr uint32_t hour_interval_seconds = quarter_hour_interval_seconds * hour_tier_t::group_count;
+
+    esp32::seqlock data_lock_;
+    sensor_value_window_t<raw_count> raw_;
+    compressed_float_ring<256, 64> full_resolution_;
+    sensor_history_percentiles_t<24 * 60 * reads_per_minute> percentiles_;
+    minute_tier_t minute_;
+    quarter_hour_tier_t quarter_hour_;
+    hour_tier_t hour_;
+    uint32_t value_count_{0}; // since boot
+    uint32_t valid_since_{0};
+
+    // readers only, typically the detail screen and the web server asking for different ranges
+    typedef struct
+    {
+        uint32_t range_seconds;
+        uint16_t max_points;
+        uint32_t sequence;
+        snapshot_handle snapshot;
+    } snapshot_cache_entry;
+
+    mutable esp32::semaphore snapshot_cache_mutex_;
+    mutable std::array<snapshot_cache_entry, 2> snapshot_cache_{};
+    mutable uint8_t next_snapshot_cache_entry_{0};
+
+    void add_value_(float value)
+    {
+        value_count_++;
+        raw_.add_value(value);
+        full_resolution_.push(value);
+        percentiles_.add_value(value);
+
+        const auto minute = minute_.add({value, value, value});
+        if (minute.has_value())
+        {
+            const auto quarter_hour = quarter_hour_.add(minute.value());
+            if (quarter_hour.has_value())
+            {
+                hour_.add(quarter_hour.value());
+            }
+        }
+    }
+
+    template <class T>
+    static void append_tier(const T &tier, uint32_t interval_seconds, uint16_t points, sensor_history_snapshot &snapshot,
+                            sensor_history_stats_accumulator &stats_accumulator)
+    {
+        snapshot.interval_seconds = interval_seconds;
+        snapshot.history.reserve(points);
+        tier.append_newest(points, snapshot.history, stats_accumulator);
+    }
+};
+
+using sensor_history = sensor_history_tiered_t<12>;
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "hardware/sensors/sensor_id.h"
+#include "util/misc.h"
+#include <array>
+#include <optional>
+#include <stdint.h>
+#include <tuple>
+
+/**
+ * Values of one measurement from a device, invalid values are NaN
+ */
+template <size_t countT> struct sensor_reading
+{
+    uint32_t time; // esp32::millis() when the measurement was fetched from the device
+    std::array<std::tuple<sensor_id_index, float>, countT> values;
+    uint32_t hold_ms{0}; // extra time the values stay valid, for devices which do not measure all the time
+};
+
+/**
+ * Devices return std::nullopt when no new measurement is available since the last read
+ */
+template <size_t countT> using optional_sensor_reading = std::optional<sensor_reading<countT>>;
@@ -18,7 +18,7 @@ void sht3x_sensor_device::init()
     CHECK_THROW_ESP(sht3x_init(&sht3x_sensor_));
 }
 
-std::array<std::tuple<sensor_id_index, float>, 3> sht3x_sensor_device::read()
+optional_sensor_reading<3> sht3x_sensor_device::read()
 {
     float temperatureC = NAN;
     float humidity = NAN;
@@ -32,11 +32,13 @@ std::array<std::tuple<sensor_id_index, float>, 3> sht3x_sensor_device::read()
     else
     {
         ESP_LOGE(SENSOR_SHT31_TAG, "Failed to read from SHT3x sensor with error:%s", esp_err_to_name(err));
+        stats_.record_error(err);
     }
 
-    return {std::tuple<sensor_id_index, float>{sensor_id_index::temperatureC, esp32::round_with_precision(temperatureC, 0.01)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::temperatureF, esp32::round_with_precision(temperatureF, 0.1)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::humidity, esp32::round_with_precision(humidity, 1)}};
+    return sensor_reading<3>{esp32::millis(),
+                             {std::tuple<sensor_id_index, float>{sensor_id_index::temperatureC, esp32::round_with_precision(temperatureC, 0.01)},
+                              std::tuple<sensor_id_index, float>{sensor_id_index::temperatureF, esp32::round_with_precision(temperatureF, 0.1)},
+                              std::tuple<sensor_id_index, float>{sensor_id_index::humidity, esp32::round_with_precision(humidity, 1)}}};
 }
 
 uint8_t sht3x_sensor_device::get_initial_delay()
@@ -2,7 +2,9 @@
 #include "sdkconfig.h"
 
 #ifdef CONFIG_SHT3X_SENSOR_ENABLE
+#include "hardware/sensors/sensor_device_stats.h"
 #include "hardware/sensors/sensor_id.h"
+#include "hardware/sensors/sensor_reading.h"
 #include "util/singleton.h"
 #include <array>
 #include <i2cdev.h>
@@ -12,13 +14,21 @@
 class sht3x_sensor_device final : public esp32::singleton<sht3x_sensor_device>
 {
   public:
+    static constexpr uint32_t measurement_interval_ms = 0; // single shot measurement on every read
+
     void init();
-    std::array<std::tuple<sensor_id_index, float>, 3> read();
+    optional_sensor_reading<3> read();
+
+    sensor_device_stats &get_stats()
+    {
+        return stats_;
+    }
 
     uint8_t get_initial_delay();
 
   private:
     sht3x_t sht3x_sensor_{};
+    sensor_device_stats stats_{"SHT3x"};
 
     sht3x_sensor_device() = default;
     friend class esp32::singleton<sht3x_sensor_device>;
@@ -5,8 +5,10 @@
 #include "logging/logging_tags.h"
 #include "sps30/sps30.h"
 #include "util/exceptions.h"
+#include "util/helper.h"
 #include "util/noncopyable.h"
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <i2cdev.h>
 
 void sps30_sensor_device::init()
@@ -19,15 +21,15 @@ void sps30_sensor_device::init()
     sps30_sensor_.cfg.master.clk_speed = 100 * 1000; // 100 Kbits
     ESP_ERROR_CHECK(i2c_dev_create_mutex(&sps30_sensor_));
 
+    init_time_us_ = esp_timer_get_time();
+
     const auto sps_error = sps30_probe();
     if (sps_error == NO_ERROR)
     {
         ESP_LOGI(SENSOR_SPS30_TAG, "SPS30 Found");
 
-        const auto sps_error1 = sps30_start_measurement();
-        if (sps_error1 != NO_ERROR)
+        if (!start_measurement())
         {
-            ESP_LOGE(SENSOR_SPS30_TAG, "SPS30 start measurement failed with :%d", sps_error1);
             CHECK_THROW_ESP2(ESP_FAIL, "sps30 init failed");
         }
     }
@@ -38,31 +40,60 @@ void sps30_sensor_device::init()
     }
 }
 
-std::array<std::tuple<sensor_id_index, float>, 5> sps30_sensor_device::read()
+optional_sensor_reading<5> sps30_sensor_device::read()
 {
+    const uint32_t now = esp32::millis();
+    const uint32_t sample_period = sample_period_ms_;
+
+    switch (state_)
+    {
+    case state::sleeping:
+        if (sample_period && (now - window_start_ < sample_period))
+        {
+            not_ready_until_ = window_start_ + sample_period;
+            return std::nullopt;
+        }
+        start_measurement();
+        return std::nullopt;
+
+    case state::warming_up:
+        if (now - window_start_ < warm_up_ms)
+        {
+            return std::nullopt;
+        }
+
+        // the measurement ready now may have started during the warm up
+        discard_measurement();
+        state_ = state::measuring;
+        burst_remaining_ = burst_measurements;
+        burst_start_ = now;
+        not_ready_until_ = now + measurement_interval_ms;
+        return std::nullopt;
+
+    case state::measuring:
+        break;
+    }
+
     uint16_t ready{0};
     sps30_measurement measurement{NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN};
     auto error = sps30_read_data_ready(&ready);
     if (error == NO_ERROR)
     {
-        if (ready)
+        if (!ready)
         {
-            const auto error = sps30_read_measurement(&measurement);
-            if (error == NO_ERROR)
-            {
-                ESP_LOGI(SENSOR_SPS30_TAG, "Read SPS30 sensor values PM2.5:%g, PM1:%g, PM4:%g, PM10:%g, Particle Size:%g", measurement.mc_2p5,
-                         measurement.mc_1p0, measurement.mc_4p0, measurement.mc_10p0, measurement.typical_particle_size);
-            }
-            else
-            {
-                ESP_LOGE(SENSOR_SPS30_TAG, "Failed to read from SPS30 sensor with failed to read measurement error:0x%x", error);
-            }
-            last_measurement_value_.store(measurement);
+            ESP_LOGD(SENSOR_SPS30_TAG, "No new measurement");
+            return std::nullopt;
+        }
+
+        const auto error = sps30_read_measurement(&measurement);
+        if (error == NO_ERROR)
+        {
+            ESP_LOGI(SENSOR_SPS30_TAG, "Read SPS30 sensor values PM2.5:%g, PM1:%g, PM4:%g, PM10:%g, Particle Size:%g", measurement.mc_2p5,
+                     measurement.mc_1p0, measurement.mc_4p0, measurement.mc_10p0, measurement.typical_particle_size);
         }
         else
         {
-            ESP_LOGI(SENSOR_SPS30_TAG, "Returning last stored values");
-            last_measurement_value_.update(measurement);
+            ESP_LOGE(SENSOR_SPS30_TAG, "Failed to read from SPS30 sensor with failed to read measurement error:0x%x", error);
         }
     }
     else
@@ -70,16 +101,126 @@ std::array<std::tuple<sensor_id_index, float>, 5> sps30_sensor_device::read()
         ESP_LOGE(SENSOR_SPS30_TAG, "Failed to read from SPS30 sensor with failed to read measurement error:0x%x", error);
     }
 
-    return {std::tuple<sensor_id_index, float>{sensor_id_index::pm_10, esp32::round_with_precision(measurement.mc_10p0, 1)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::pm_1, esp32::round_with_precision(measurement.mc_1p0, 1)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::pm_2_5, esp32::round_with_precision(measurement.mc_2p5, 1)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::pm_4, esp32::round_with_precision(measurement.mc_4p0, 1)},
-            std::tuple<sensor_id_index, float>{sensor_id_index::typical_particle_size,
-                                               esp32::round_with_precision(measurement.typical_particle_size, 0.1)}};
+    if (sample_period)
+    {
+        // failed reads count too, so that the device is not left on. The next burst read, or a retry of a
+        // failed stop, is after the next measurement.
+        not_ready_until_ = now + measurement_interval_ms;
+        if (burst_remaining_ > 1)
+        {
+            burst_remaining_--;
+        }
+        else
+        {
+            // a read per measurement, with a read of slack for a measurement not ready in time
+            last_burst_ms_ = now - burst_start_;
+            if (last_burst_ms_ > (burst_measurements + 1) * measurement_interval_ms)
+            {
+                ESP_LOGW(SENSOR_SPS30_TAG, "SPS30 burst took %lu ms, expected about %lu ms", last_burst_ms_.load(),
+                         burst_measurements * measurement_interval_ms);
+            }
+            stop_measurement();
+        }
+    }
+
+    // values are held until the next window
+    return sensor_reading<5>{
+        esp32::millis(),
+        {std::tuple<sensor_id_index, float>{sensor_id_index::pm_10, esp32::round_with_precision(measurement.mc_10p0, 1)},
+         std::tuple<sensor_id_index, float>{sensor_id_index::pm_1, esp32::round_with_precision(measurement.mc_1p0, 1)},
+         std::tuple<sensor_id_index, float>{sensor_id_index::pm_2_5, esp32::round_with_precision(measurement.mc_2p5, 1)},
+         std::tuple<sensor_id_index, float>{sensor_id_index::pm_4, esp32::round_with_precision(measurement.mc_4p0, 1)},
+         std::tuple<sensor_id_index, float>{sensor_id_index::typical_particle_size, esp32::round_with_precision(measurement.typical_particle_size, 0.1)}},
+        sample_period};
+}
+
+bool sps30_sensor_device::start_measurement()
+{
+    if (asleep_)
+    {
+        const auto error = sps30_wake_up();
+        if (error != NO_ERROR)
+        {
+            ESP_LOGE(SENSOR_SPS30_TAG, "SPS30 wake up failed with :%d", error);
+            return false;
+        }
+        asleep_ = false;
+    }
+
+    const auto error = sps30_start_measurement();
+    if (error != NO_ERROR)
+    {
+        ESP_LOGE(SENSOR_SPS30_TAG, "SPS30 start measurement failed with :%d", error);
+        return false;
+    }
+
+    ESP_LOGI(SENSOR_SPS30_TAG, "SPS30 measurement started");
+    window_start_ = esp32::millis();
+    not_ready_until_ = window_start_ + warm_up_ms;
+    measuring_since_us_ = esp_timer_get_time();
+    state_ = state::warming_up;
+    return true;
+}
+
+void sps30_sensor_device::stop_measurement()
+{
+    const auto error = sps30_stop_measurement();
+    if (error != NO_ERROR)
+    {
+        // tried again after the next measurement
+        ESP_LOGE(SENSOR_SPS30_TAG, "SPS30 stop measurement failed with :%d", error);
+        return;
+    }
+
+    on_time_us_ += esp_timer_get_time() - measuring_since_us_;
+    state_ = state::sleeping;
+    asleep_ = sps30_sleep() == NO_ERROR;
+    not_ready_until_ = window_start_ + sample_period_ms_;
+    ESP_LOGI(SENSOR_SPS30_TAG, "SPS30 measurement stopped, %s", asleep_ ? "sleeping" : "idle");
+}
+
+void sps30_sensor_device::discard_measurement()
+{
+    uint16_t ready{0};
+    sps30_measurement measurement;
+    if ((sps30_read_data_ready(&ready) == NO_ERROR) && ready)
+    {
+        sps30_read_measurement(&measurement);
+    }
+}
+
+uint32_t sps30_sensor_device::get_time_to_next_measurement() const
+{
+    return std::max<int32_t>(0, static_cast<int32_t>(not_ready_until_ - esp32::millis()));
+}
+
+std::string sps30_sensor_device::get_duty_cycle_status() const
+{
+    const auto now = esp_timer_get_time();
+    auto on_time = on_time_us_.load();
+    if (state_ != state::sleeping)
+    {
+        on_time += now - measuring_since_us_;
+    }
+
+    const auto elapsed = now - init_time_us_;
+    const float on_share = elapsed > 0 ? std::min<float>(1, static_cast<float>(on_time) / elapsed) : 1;
+    const auto off_current_ma = asleep_ ? sleep_current_ma : idle_current_ma;
+    const auto average_current_ma = on_share * measurement_current_ma + (1 - on_share) * off_current_ma;
+
+    const auto sample_period = sample_period_ms_.load();
+    const auto mode = sample_period ? esp32::string::sprintf("Every %lu s, burst %.1f s", sample_period / 1000, last_burst_ms_ / 1000.0f)
+                                    : std::string("Continuous");
+    return esp32::string::sprintf("%s On:%.1f%% Average current:%.1f mA", mode.c_str(), on_share * 100, average_current_ma);
 }
 
 std::string sps30_sensor_device::get_error_register_status()
 {
+    if (asleep_)
+    {
+        return "Sleeping";
+    }
+
     uint32_t device_status_flags{};
     const auto error = sps30_read_device_status_register(&device_status_flags);
 
@@ -113,6 +254,12 @@ std::string sps30_sensor_device::get_error_register_status()
 
 bool sps30_sensor_device::clean()
 {
+    if (state_ == state::sleeping)
+    {
+        ESP_LOGW(SENSOR_SPS30_TAG, "SPS30 manual clean up needs a measurement in progress");
+        return false;
+    }
+
     const auto sps_error = sps30_start_manual_fan_cleaning();
     if (sps_error != NO_ERROR)
     {
@@ -145,11 +292,14 @@ esp_err_t sps30_sensor_device::sensirion_i2c_write(uint8_t address, const uint8_
     return ESP_OK;
 }
 
-// glue functions
+// glue functions, these run on the i2c bus worker task as hardware queues every sps30 call there
 
 extern "C" int8_t sensirion_i2c_read(uint8_t address, uint8_t *data, uint16_t count)
 {
-    const auto error = sps30_sensor_device::get_instance().sensirion_i2c_read(address, data, count);
+    auto &device = sps30_sensor_device::get_instance();
+    const auto start = esp_timer_get_time();
+    const auto error = device.sensirion_i2c_read(address, data, count);
+    device.stats_.record_transfer(esp_timer_get_time() - start, error);
     if (error != ESP_OK)
     {
         ESP_LOGW(SENSOR_SPS30_TAG, "I2C Read Operation Failed with:%s", esp_err_to_name(error));
@@ -160,7 +310,10 @@ extern "C" int8_t sensirion_i2c_read(uint8_t address, uint8_t *data, uint16_t co
 
 extern "C" int8_t sensirion_i2c_write(uint8_t address, const uint8_t *data, uint16_t count)
 {
-    const auto error = sps30_sensor_device::get_instance().sensirion_i2c_write(address, data, count);
+    auto &device = sps30_sensor_device::get_instance();
+    const auto start = esp_timer_get_time();
+    const auto error = device.sensirion_i2c_write(address, data, count);
+    device.stats_.record_transfer(esp_timer_get_time() - start, error);
     if (error != ESP_OK)
     {
         ESP_LOGW(SENSOR_SPS30_TAG, "I2C Write Operation Failed with:%s", esp_err_to_name(error));
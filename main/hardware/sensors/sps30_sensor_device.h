@@ -1,19 +1,67 @@
 #pragma once
 
-#include "hardware/sensors/last_measurement_helper.h"
+#include "hardware/sensors/sensor_device_stats.h"
 #include "hardware/sensors/sensor_id.h"
+#include "hardware/sensors/sensor_reading.h"
 #include "hardware/sensors/sps30/sps30.h"
 #include "util/singleton.h"
 #include <array>
+#include <atomic>
 #include <i2cdev.h>
 #include <string>
 #include <tuple>
 
+/**
+ * Measures continuously, or in windows every sample period to save the fan and power. A window wakes the
+ * device, waits for the warm up and returns a short burst of measurements before it sleeps again.
+ * Measurements started before the end of the warm up are never returned.
+ */
 class sps30_sensor_device final : public esp32::singleton<sps30_sensor_device>
 {
   public:
+    static constexpr uint32_t measurement_interval_ms = 1000;
+
+    // datasheet: readings are stable 30 s after the start of measurement at low concentrations
+    static constexpr uint32_t warm_up_ms = 30 * 1000;
+    static constexpr uint8_t burst_measurements = 3; // enough for the median filter
+    static constexpr uint32_t min_sample_period_ms = 2 * warm_up_ms;
+    static constexpr uint32_t max_sample_period_ms = 60 * 60 * 1000; // longer leaves the history without values
+
+    // datasheet typical supply currents
+    static constexpr float measurement_current_ma = 60;
+    static constexpr float idle_current_ma = 0.33;
+    static constexpr float sleep_current_ma = 0.038;
+
     void init();
-    std::array<std::tuple<sensor_id_index, float>, 5> read();
+    optional_sensor_reading<5> read();
+
+    sensor_device_stats &get_stats()
+    {
+        return stats_;
+    }
+
+    /**
+     * 0 measures continuously, otherwise min_sample_period_ms to max_sample_period_ms. Can be called from any task.
+     */
+    void set_sample_period_ms(uint32_t sample_period_ms)
+    {
+        sample_period_ms_ = sample_period_ms ? std::max(sample_period_ms, min_sample_period_ms) : 0;
+    }
+
+    /**
+     * A duty cycled device paces its reads itself, a burst takes about burst_measurements seconds
+     */
+    bool is_duty_cycled() const
+    {
+        return sample_period_ms_ != 0;
+    }
+
+    uint32_t get_time_to_next_measurement() const;
+
+    /**
+     * Share of the time the fan and laser were on since init, and the average current from it. Can be called from any task.
+     */
+    std::string get_duty_cycle_status() const;
 
     std::string get_error_register_status();
     bool clean();
@@ -21,8 +69,33 @@ class sps30_sensor_device final : public esp32::singleton<sps30_sensor_device>
     uint16_t get_initial_delay_ms();
 
   private:
+    enum class state : uint8_t
+    {
+        sleeping, // or idle if the firmware does not support sleep
+        warming_up,
+        measuring,
+    };
+
     i2c_dev_t sps30_sensor_{};
-    last_measurement_helper<sps30_measurement, 2000> last_measurement_value_;
+    sensor_device_stats stats_{"SPS30"};
+
+    std::atomic_uint32_t sample_period_ms_{0};
+    std::atomic<state> state_{state::sleeping};
+    uint32_t window_start_{0}; // esp32::millis() when measurement was started
+    uint8_t burst_remaining_{0};
+    uint32_t burst_start_{0};
+    std::atomic_uint32_t last_burst_ms_{0};
+    std::atomic_bool asleep_{false}; // sleep needs firmware 2.0, older ones stay idle
+    std::atomic_uint32_t not_ready_until_{0};
+
+    // on time is kept in microseconds from esp_timer_get_time(), which does not wrap
+    int64_t init_time_us_{0};
+    std::atomic<int64_t> measuring_since_us_{0};
+    std::atomic<int64_t> on_time_us_{0};
+
+    bool start_measurement();
+    void stop_measurement();
+    void discard_measurement();
 
     esp_err_t sensirion_i2c_read(uint8_t address, uint8_t *data, uint16_t count);
     esp_err_t sensirion_i2c_write(uint8_t address, const uint8_t *data, uint16_t count);
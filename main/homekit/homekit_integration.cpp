@@ -291,9 +291,10 @@ void homekit_integration::app_event_handler(esp_event_base_t base, int32_t event
 {
     switch (event)
     {
-    case SENSOR_VALUE_CHANGE: {
-        const auto id = (*reinterpret_cast<sensor_id_index *>(data));
-        xTaskNotify(homekit_task_.handle(), BIT(static_cast<uint8_t>(id) + 1), eSetBits);
+    case SENSOR_VALUES_CHANGE: {
+        // bit i + 1 is sensor i
+        const auto changed = reinterpret_cast<const sensor_values_change *>(data)->changed;
+        xTaskNotify(homekit_task_.handle(), changed << 1, eSetBits);
     }
     break;
     case APP_EVENT_REBOOT:
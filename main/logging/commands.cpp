@@ -1,6 +1,8 @@
 #include "commands.h"
+#include "hardware/sensors/sensor_device_stats.h"
 #include "logging/logger.h"
 #include "logging/logging_tags.h"
+#include "ui/ui_interface.h"
 #include "util/helper.h"
 #include <esp_log.h>
 #include <esp_timer.h>
@@ -123,7 +125,36 @@ static void sock_dump_cli_handler()
     ESP_LOGI(COMMAND_TAG, "Remaining sockets: %d", TOTAL_NUM_SOCKETS - used_sockets);
 }
 
-void run_command(const std::string_view &command)
+static void sensor_stats_cli_handler(ui_interface &ui_interface)
+{
+    ESP_LOGI(COMMAND_TAG, "Device     Reads  NotReady  Errors  NaN  Timeouts  Stalls  Healthy  LastError");
+    ui_interface.for_each_sensor_device_stats([](const sensor_device_stats &stats) {
+        ESP_LOGI(COMMAND_TAG, "%-8s %7lu  %8lu  %6lu  %3lu  %8lu  %6lu  %-7s  %s", stats.get_name(), stats.get_reads(), stats.get_not_ready(),
+                 stats.get_errors(), stats.get_nan_values(), stats.get_timeouts(), stats.get_stalls(), stats.is_healthy() ? "yes" : "no",
+                 esp_err_to_name(stats.get_last_error()));
+
+        std::string read_latency;
+        std::string transfer_latency;
+        const auto read_latency_values = stats.get_read_latency().get();
+        const auto transfer_latency_values = stats.get_transfer_latency().get();
+        for (auto i = 0; i < latency_histogram::bucket_count; i++)
+        {
+            read_latency += esp32::string::sprintf(" %lu", read_latency_values.buckets[i]);
+            transfer_latency += esp32::string::sprintf(" %lu", transfer_latency_values.buckets[i]);
+        }
+        ESP_LOGI(COMMAND_TAG, "  read latency buckets:%s", read_latency.c_str());
+        ESP_LOGI(COMMAND_TAG, "  transfer latency buckets:%s", transfer_latency.c_str());
+    });
+
+    std::string limits;
+    for (const auto limit : latency_histogram::bucket_limits)
+    {
+        limits += esp32::string::sprintf(" %lu", limit);
+    }
+    ESP_LOGI(COMMAND_TAG, "Latency bucket limits (us):%s and above", limits.c_str());
+}
+
+void run_command(ui_interface &ui_interface, const std::string_view &command)
 {
     esp_log_level_set(COMMAND_TAG, ESP_LOG_INFO);
     if (command == "up-time")
@@ -146,4 +177,8 @@ void run_command(const std::string_view &command)
     {
         sock_dump_cli_handler();
     }
+    else if (command == "sensor-stats")
+    {
+        sensor_stats_cli_handler(ui_interface);
+    }
 }
@@ -2,4 +2,6 @@
 
 #include <string_view>
 
-void run_command(const std::string_view &command);
\ No newline at end of file
+class ui_interface;
+
+void run_command(ui_interface &ui_interface, const std::string_view &command);
\ No newline at end of file
@@ -47,7 +47,11 @@ extern "C" void app_main(void)
         auto &wifi_manager = wifi_manager::create_instance(config);
         auto &ui_interface = ui_interface::create_instance();
         auto &display = display::create_instance(config, ui_interface);
+#ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
+        auto &hardware = hardware::create_instance(config, display, sd_card);
+#else
         auto &hardware = hardware::create_instance(config, display);
+#endif
         auto &homekit_integration = homekit_integration::create_instance(config, hardware);
 #ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
         auto &logger = logger::create_instance(sd_card);
@@ -25,10 +25,10 @@ float ui_interface::get_sensor_value(sensor_id_index index)
     return hardware_->get_sensor_value(index);
 }
 
-sensor_history::sensor_history_snapshot ui_interface::get_sensor_detail_info(sensor_id_index index)
+sensor_history::snapshot_handle ui_interface::get_sensor_detail_info(sensor_id_index index, uint32_t range_seconds, uint16_t max_points)
 {
     configASSERT(hardware_);
-    return hardware_->get_sensor_detail_info(index);
+    return hardware_->get_sensor_detail_info(index, range_seconds, max_points);
 }
 
 wifi_status ui_interface::get_wifi_status()
@@ -43,6 +43,12 @@ bool ui_interface::clean_sps_30()
     return hardware_->clean_sps_30();
 }
 
+void ui_interface::for_each_sensor_device_stats(const std::function<void(const sensor_device_stats &)> &ftn)
+{
+    configASSERT(hardware_);
+    hardware_->for_each_device_stats(ftn);
+}
+
 #ifdef CONFIG_SCD4x_SENSOR_ENABLE
 bool ui_interface::factory_reset_scd4x()
 {
@@ -252,6 +258,8 @@ ui_interface::information_table_type ui_interface::get_information_table(informa
             {"SD Card", sd_card_->get_info()},
 #endif
             {"SPS30 sensor status", hardware_->get_sps30_error_register_status()},
+            {"SPS30 duty cycle", hardware_->get_sps30_duty_cycle_status()},
+            {"Sensor change events", hardware_->get_sensor_events_status()},
         };
 
     case information_type::homekit: {
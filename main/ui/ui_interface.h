@@ -1,10 +1,12 @@
 #pragma once
 
 #include "hardware/sensors/sensor.h"
+#include "hardware/sensors/sensor_device_stats.h"
 #include "hardware/sensors/sensor_id.h"
 #include "util/psram_allocator.h"
 #include "util/singleton.h"
 #include "wifi/wifi_manager.h"
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -31,7 +33,8 @@ class ui_interface : public esp32::singleton<ui_interface>
     void set_screen_brightness(uint8_t value);
     const sensor_value &get_sensor(sensor_id_index index);
     float get_sensor_value(sensor_id_index index);
-    sensor_history::sensor_history_snapshot get_sensor_detail_info(sensor_id_index index);
+    sensor_history::snapshot_handle get_sensor_detail_info(sensor_id_index index, uint32_t range_seconds = sensor_history::default_range_seconds,
+                                                           uint16_t max_points = sensor_history::default_max_points);
     wifi_status get_wifi_status();
     std::string get_sps30_error_register_status();
 
@@ -42,6 +45,7 @@ class ui_interface : public esp32::singleton<ui_interface>
     void reenable_homekit_pairing();
 
     bool clean_sps_30();
+    void for_each_sensor_device_stats(const std::function<void(const sensor_device_stats &)> &ftn);
 
 #ifdef CONFIG_SCD4x_SENSOR_ENABLE
     bool factory_reset_scd4x();
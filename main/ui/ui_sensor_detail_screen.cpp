@@ -46,6 +46,10 @@ void ui_sensor_detail_screen::init()
         lv_obj_set_style_size(sensor_detail_screen_chart, 0, LV_PART_INDICATOR);
         sensor_detail_screen_chart_series =
             lv_chart_add_series(sensor_detail_screen_chart, lv_theme_get_color_primary(sensor_detail_screen_chart), LV_CHART_AXIS_PRIMARY_Y);
+        // P95 of the last day as a reference line
+        sensor_detail_screen_chart_p95_series =
+            lv_chart_add_series(sensor_detail_screen_chart, lv_palette_main(LV_PALETTE_ORANGE), LV_CHART_AXIS_PRIMARY_Y);
+        lv_chart_hide_series(sensor_detail_screen_chart, sensor_detail_screen_chart_p95_series, true);
         lv_obj_set_style_text_font(sensor_detail_screen_chart, &all_14_font, LV_PART_MAIN | LV_STATE_DEFAULT);
         lv_chart_set_axis_tick(sensor_detail_screen_chart, LV_CHART_AXIS_PRIMARY_Y, 5, 1, 3, 1, true, 200);
         lv_chart_set_axis_tick(sensor_detail_screen_chart, LV_CHART_AXIS_PRIMARY_X, 10, 5, chart_total_x_ticks, 1, true, 50);
@@ -242,7 +246,7 @@ void ui_sensor_detail_screen::chart_draw_event_cb(lv_event_t *e)
     {
         if (sensor_detail_screen_chart_series_data.size())
         {
-            const auto data_interval_seconds = (sensor_detail_screen_chart_series_data.size() * 60);
+            const auto data_interval_seconds = (sensor_detail_screen_chart_series_data.size() * sensor_detail_screen_chart_series_interval);
             const float interval = float(chart_total_x_ticks - 1 - dsc->value) / (chart_total_x_ticks - 1);
             // ESP_LOGI("total seconds :%d,  Series length: %d,  %f", data_interval_seconds, sensor_detail_screen_chart_series_data.size(),
             // interval);
@@ -265,7 +269,8 @@ void ui_sensor_detail_screen::set_current_values(sensor_id_index index, float va
 {
     sensor_detail_screen_chart_series_time = esp32::millis() / 1000;
 
-    auto &&sensor_info = ui_interface_instance_.get_sensor_detail_info(index);
+    const auto sensor_info_handle = ui_interface_instance_.get_sensor_detail_info(index);
+    auto &&sensor_info = *sensor_info_handle;
 
     if (sensor_info.stat.has_value())
     {
@@ -279,6 +284,7 @@ void ui_sensor_detail_screen::set_current_values(sensor_id_index index, float va
         set_value_in_panel(panel_and_labels_[label_and_unit_label_max_index], index, stats.max);
 
         auto &&values = sensor_info.history;
+        sensor_detail_screen_chart_series_interval = sensor_info.interval_seconds;
 
         set_value_in_panel(panel_and_labels_[label_and_unit_label_current_index], index, values[values.size() - 1]);
 
@@ -290,10 +296,23 @@ void ui_sensor_detail_screen::set_current_values(sensor_id_index index, float va
         sensor_detail_screen_chart_series_data.resize(values.size());
         for (auto index = 0; index < sensor_detail_screen_chart_series_data.size(); index++)
         {
-            sensor_detail_screen_chart_series_data[index] = std::lroundf(values[index] * graph_multiplier);
+            sensor_detail_screen_chart_series_data[index] =
+                std::isnan(values[index]) ? LV_CHART_POINT_NONE : std::lroundf(values[index] * graph_multiplier);
         }
 
         lv_chart_set_ext_y_array(sensor_detail_screen_chart, sensor_detail_screen_chart_series, sensor_detail_screen_chart_series_data.data());
+
+        // only drawn when within the range of the chart
+        if (sensor_info.percentiles.has_value() && sensor_info.percentiles->p95 >= stats.min && sensor_info.percentiles->p95 <= stats.max)
+        {
+            lv_chart_set_all_value(sensor_detail_screen_chart, sensor_detail_screen_chart_p95_series,
+                                   std::lroundf(sensor_info.percentiles->p95 * graph_multiplier));
+            lv_chart_hide_series(sensor_detail_screen_chart, sensor_detail_screen_chart_p95_series, false);
+        }
+        else
+        {
+            lv_chart_hide_series(sensor_detail_screen_chart, sensor_detail_screen_chart_p95_series, true);
+        }
     }
     else
     {
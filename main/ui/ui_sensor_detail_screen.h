@@ -20,8 +20,10 @@ class ui_sensor_detail_screen final : public ui_screen_with_sensor_panel
     lv_obj_t *sensor_detail_screen_top_label_units{};
     lv_obj_t *sensor_detail_screen_chart{};
     lv_chart_series_t *sensor_detail_screen_chart_series{};
+    lv_chart_series_t *sensor_detail_screen_chart_p95_series{};
     std::vector<lv_coord_t> sensor_detail_screen_chart_series_data;
     uint64_t sensor_detail_screen_chart_series_time;
+    uint32_t sensor_detail_screen_chart_series_interval{60};
     constexpr static uint8_t chart_total_x_ticks = 4;
 
     std::array<panel_and_label, 4> panel_and_labels_;
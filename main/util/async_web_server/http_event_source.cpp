@@ -35,6 +35,7 @@ void event_source_connection::destroy(void *ptr)
     ESP_LOGI(WEBSERVER_TAG, "events disconnect");
     auto *connection = static_cast<event_source_connection *>(ptr);
     connection->source_.connections_.erase(connection);
+    connection->source_.clients_.add(-1);
     delete connection;
 }
 
@@ -107,6 +108,7 @@ void event_source::add_request(http_request &request)
     auto connection = new event_source_connection(*this, request);
     std::lock_guard<esp32::semaphore> lock(connections_mutex_);
     connections_.insert(connection);
+    clients_.add(1);
 }
 
 void event_source::try_send(const char *message, const char *event, uint32_t id, uint32_t reconnect)
@@ -117,6 +119,11 @@ void event_source::try_send(const char *message, const char *event, uint32_t id,
         connections_copy = connections_;
     }
 
+    if (!connections_copy.empty())
+    {
+        events_sent_.add();
+    }
+
     for (auto *ses : connections_copy)
     {
         ses->try_send(message, event, id, reconnect);
@@ -125,8 +132,7 @@ void event_source::try_send(const char *message, const char *event, uint32_t id,
 
 size_t event_source::connection_count() const
 {
-    std::lock_guard<esp32::semaphore> lock(connections_mutex_);
-    return connections_.size();
+    return clients_.get();
 }
 
 } // namespace esp32
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "http_request.h"
 #include "http_response.h"
+#include "util/metrics.h"
 #include "util/noncopyable.h"
 #include "util/semaphore_lockable.h"
 #include <set>
@@ -33,9 +34,22 @@ class event_source : esp32::noncopyable
 
     size_t connection_count() const;
 
+    const metrics::gauge &get_clients() const
+    {
+        return clients_;
+    }
+
+    // events sent to the connected clients, one per try_send
+    const metrics::counter &get_events_sent() const
+    {
+        return events_sent_;
+    }
+
   protected:
     friend class event_source_connection;
     std::set<event_source_connection *> connections_;
     mutable esp32::semaphore connections_mutex_;
+    metrics::gauge clients_;
+    metrics::counter events_sent_;
 };
 } // namespace esp32
\ No newline at end of file
@@ -42,6 +42,7 @@ class http_request : esp32::noncopyable
 
     friend class http_response;
     friend class array_response;
+    friend class chunked_response;
     friend class fs_card_file_response;
     friend class event_source_connection;
 
@@ -6,6 +6,7 @@
 #include "util/filesystem/filesystem.h"
 #include "util/finally.h"
 #include "util/helper.h"
+#include <algorithm>
 #include <esp_check.h>
 #include <esp_log.h>
 #include <filesystem>
@@ -45,6 +46,47 @@ void http_response::send_error(httpd_err_code_t code, const char *message)
     CHECK_THROW_ESP(httpd_resp_send_err(request_.req_, code, message));
 }
 
+bool http_response::send_not_modified(const std::string_view &etag)
+{
+    const auto match_etag = request_.get_header("If-None-Match");
+    if (!match_etag.has_value())
+    {
+        return false;
+    }
+
+    const auto opaque_tag = [](std::string_view tag) {
+        while (!tag.empty() && (tag.front() == ' '))
+        {
+            tag.remove_prefix(1);
+        }
+        while (!tag.empty() && (tag.back() == ' '))
+        {
+            tag.remove_suffix(1);
+        }
+        return tag.starts_with("W/") ? tag.substr(2) : tag;
+    };
+
+    const auto tag = opaque_tag(etag);
+    std::string_view tags = match_etag.value();
+    bool matched = false;
+    while (!matched && !tags.empty())
+    {
+        const auto separator = tags.find(',');
+        const auto match = opaque_tag(tags.substr(0, separator));
+        matched = (match == "*") || (match == tag);
+        tags = (separator == std::string_view::npos) ? std::string_view{} : tags.substr(separator + 1);
+    }
+    if (!matched)
+    {
+        return false;
+    }
+
+    add_common_headers();
+    CHECK_THROW_ESP(httpd_resp_set_status(request_.req_, "304 Not Modified"));
+    CHECK_THROW_ESP(httpd_resp_send(request_.req_, "", 0));
+    return true;
+}
+
 void array_response::send_response()
 {
     ESP_LOGD(WEBSERVER_TAG, "Handling %s", request_.url().c_str());
@@ -82,6 +124,55 @@ void array_response::send_response(esp32::http_request &request, const std::stri
     response.send_response();
 }
 
+chunked_response::chunked_response(const http_request &req, const std::string_view &content_type, const std::optional<std::string_view> &etag)
+    : http_response(req)
+{
+    ESP_LOGD(WEBSERVER_TAG, "Handling %s", request_.url().c_str());
+    add_common_headers();
+    CHECK_THROW_ESP(httpd_resp_set_type(request_.req_, content_type.data()));
+    CHECK_THROW_ESP(httpd_resp_set_status(request_.req_, HTTPD_200));
+    if (etag.has_value())
+    {
+        // headers are sent with the first chunk, the value must outlive it
+        CHECK_THROW_ESP(httpd_resp_set_hdr(request_.req_, "ETag", etag.value().data()));
+        CHECK_THROW_ESP(httpd_resp_set_hdr(request_.req_, "Cache-Control", "no-cache"));
+    }
+}
+
+size_t chunked_response::write(const uint8_t *data, size_t size)
+{
+    const auto written = size;
+    while (size)
+    {
+        if (length_ == scratch_.size())
+        {
+            flush();
+        }
+
+        const auto copy = std::min(size, scratch_.size() - length_);
+        std::copy_n(data, copy, scratch_.begin() + length_);
+        length_ += copy;
+        data += copy;
+        size -= copy;
+    }
+    return written;
+}
+
+void chunked_response::flush()
+{
+    if (length_)
+    {
+        CHECK_THROW_ESP(httpd_resp_send_chunk(request_.req_, scratch_.data(), length_));
+        length_ = 0;
+    }
+}
+
+void chunked_response::finish()
+{
+    flush();
+    CHECK_THROW_ESP(httpd_resp_send_chunk(request_.req_, nullptr, 0));
+}
+
 void fs_card_file_response::send_response()
 {
     ESP_LOGD(WEBSERVER_TAG, "Handling %s", request_.url().c_str());
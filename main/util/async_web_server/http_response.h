@@ -2,6 +2,7 @@
 
 #include "util/noncopyable.h"
 #include <esp_http_server.h>
+#include <array>
 #include <optional>
 #include <set>
 #include <span>
@@ -25,6 +26,11 @@ class http_response : esp32::noncopyable
     void send_empty_200();
     void send_error(httpd_err_code_t code, const char *message = nullptr);
 
+    /**
+     * Sends 304 if the If-None-Match list of the request matches `etag`, a quoted entity tag. Weak tags match too.
+     */
+    bool send_not_modified(const std::string_view &etag);
+
   protected:
     const http_request &request_;
 };
@@ -49,6 +55,43 @@ class array_response final : http_response
     const bool is_gz_;
 };
 
+/**
+ * Response sent as http chunks of at most scratch_size, so it is never held in memory as a whole.
+ * Works as an ArduinoJson writer, e.g. serializeJson(document, response). finish() sends the end.
+ */
+class chunked_response final : http_response
+{
+  public:
+    static constexpr size_t scratch_size = 1024;
+
+    chunked_response(const http_request &req, const std::string_view &content_type, const std::optional<std::string_view> &etag = std::nullopt);
+
+    size_t write(uint8_t c)
+    {
+        if (length_ == scratch_.size())
+        {
+            flush();
+        }
+        scratch_[length_++] = c;
+        return 1;
+    }
+
+    size_t write(const uint8_t *data, size_t size);
+
+    size_t write(const std::string_view &data)
+    {
+        return write(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+    }
+
+    void finish();
+
+  private:
+    std::array<char, scratch_size> scratch_;
+    size_t length_{0};
+
+    void flush();
+};
+
 class fs_card_file_response final : http_response
 {
   public:
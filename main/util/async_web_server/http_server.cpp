@@ -3,7 +3,10 @@
 #include "logging/logging_tags.h"
 #include "util/cores.h"
 #include "util/task_wrapper.h"
+#include <algorithm>
+#include <cstring>
 #include <esp_log.h>
+#include <esp_timer.h>
 
 namespace esp32
 {
@@ -25,7 +28,7 @@ void http_server::begin()
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.server_port = port_;
     config.task_priority = esp32::task::default_priority;
-    config.max_uri_handlers = 45;
+    config.max_uri_handlers = max_uri_handlers;
     config.ctrl_port = 32760;
     config.core_id = esp32::http_server_core;
     config.stack_size = 6 * 1024;
@@ -46,11 +49,54 @@ void http_server::end()
 
 void http_server::add_handler(const char *url, httpd_method_t method, url_handler request_handler, const void *user_ctx)
 {
+    // the route of an earlier begin is reused, it keeps its latency
+    const auto count = routes_count_.load(std::memory_order_relaxed);
+    auto existing = std::find_if(routes_.begin(), routes_.begin() + count,
+                                 [url, method](const route &route) { return route.method == method && std::strcmp(route.url, url) == 0; });
+    if (existing == routes_.begin() + count)
+    {
+        if (count == routes_.size())
+        {
+            CHECK_THROW_ESP2(ESP_ERR_HTTPD_HANDLERS_FULL, "Too many uri handlers");
+        }
+        existing->url = url;
+        existing->method = method;
+    }
+    existing->handler = request_handler;
+    existing->user_ctx = const_cast<void *>(user_ctx);
+    if (existing == routes_.begin() + count)
+    {
+        routes_count_.store(count + 1, std::memory_order_release);
+    }
+
     httpd_uri_t handler{};
     handler.uri = url;
     handler.method = method;
-    handler.handler = request_handler;
-    handler.user_ctx = const_cast<void *>(user_ctx);
+    handler.handler = timed_handler;
+    handler.user_ctx = &*existing;
     CHECK_THROW_ESP(httpd_register_uri_handler(server_, &handler));
 }
+
+esp_err_t http_server::timed_handler(httpd_req_t *r)
+{
+    auto &route = *reinterpret_cast<http_server::route *>(r->user_ctx);
+    r->user_ctx = route.user_ctx;
+
+    const auto start = esp_timer_get_time();
+    const auto result = route.handler(r);
+    route.latency.add(std::min<int64_t>(esp_timer_get_time() - start, UINT32_MAX));
+    return result;
+}
+
+void http_server::collect(esp32::metrics::writer &writer) const
+{
+    writer.family("http_request_duration_seconds", "Time to handle a http request", esp32::metrics::metric_type::histogram);
+
+    const auto count = routes_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+        writer.histogram("http_request_duration_seconds", {{"route", routes_[i].url}, {"method", http_method_str(routes_[i].method)}},
+                         routes_[i].latency, 1e-6);
+    }
+}
 } // namespace esp32
@@ -4,7 +4,10 @@
 #include "util/async_web_server/http_request.h"
 #include "util/async_web_server/http_response.h"
 #include "util/exceptions.h"
+#include "util/metrics.h"
 #include "util/noncopyable.h"
+#include <array>
+#include <atomic>
 #include <esp_http_server.h>
 #include <esp_log.h>
 #include <type_traits>
@@ -12,12 +15,14 @@
 
 namespace esp32
 {
-class http_server : esp32::noncopyable
+class http_server : esp32::noncopyable, protected esp32::metrics::collector
 {
   public:
     typedef esp_err_t (*url_handler)(httpd_req_t *r);
     typedef void (*url_handler_with_exception)(httpd_req_t *r);
 
+    static constexpr size_t max_uri_handlers = 48;
+
     http_server(uint16_t port) : port_(port){};
     ~http_server();
 
@@ -25,6 +30,9 @@ class http_server : esp32::noncopyable
     virtual void end();
 
   protected:
+    // request latency per route
+    void collect(esp32::metrics::writer &writer) const override;
+
     void add_handler(const char *url, httpd_method_t method, url_handler request_handler, const void *user_ctx);
 
     template <void (*ftn)(httpd_req_t *r)> void add_handler_with_exceptions(const char *url, httpd_method_t method, const void *user_ctx)
@@ -119,9 +127,27 @@ class http_server : esp32::noncopyable
         }
     }
 
+    static esp_err_t timed_handler(httpd_req_t *r);
+
   private:
+    using latency_histogram = esp32::metrics::histogram<1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 5000000>;
+
+    // handlers are registered through their route, which keeps the latency of the uri
+    struct route
+    {
+        const char *url;
+        httpd_method_t method;
+        url_handler handler;
+        void *user_ctx;
+        latency_histogram latency;
+    };
+
     const uint16_t port_{};
 
+    // only appended to, collect reads the routes published by routes_count_ without a lock
+    std::array<route, max_uri_handlers> routes_{};
+    std::atomic_size_t routes_count_{0};
+
   protected:
     httpd_handle_t server_{};
 };
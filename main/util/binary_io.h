@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Raw binary read/write helpers over any stream with fread/fwrite like
+ * `read(buffer, size, count)` and `write(buffer, size, count)`, e.g. esp32::filesystem::file.
+ * Values are stored in native layout, files are only meant to be read back by the same firmware.
+ */
+namespace esp32::binary_io
+{
+template <class S, class T>
+    requires std::is_trivially_copyable_v<T>
+bool write(S &stream, const T &value)
+{
+    return stream.write(&value, sizeof(T), 1) == 1;
+}
+
+template <class S, class T>
+    requires std::is_trivially_copyable_v<T>
+bool read(S &stream, T &value)
+{
+    return stream.read(&value, sizeof(T), 1) == 1;
+}
+
+/**
+ * Writes the element count followed by the elements, oldest first
+ */
+template <class S, class B> bool write_buffer(S &stream, const B &buffer)
+{
+    const typename B::index_t size = buffer.size();
+    if (!write(stream, size))
+    {
+        return false;
+    }
+
+    const auto [first, second] = buffer.as_spans();
+    return stream.write(first.data(), sizeof(first[0]), first.size()) == first.size() &&
+           stream.write(second.data(), sizeof(second[0]), second.size()) == second.size();
+}
+
+template <class S, class B> bool read_buffer(S &stream, B &buffer)
+{
+    buffer.clear();
+    typename B::index_t size;
+    if (!read(stream, size) || size > B::capacity)
+    {
+        return false;
+    }
+
+    for (typename B::index_t i = 0; i < size; i++)
+    {
+        std::remove_cvref_t<decltype(buffer.first())> value;
+        if (!read(stream, value))
+        {
+            return false;
+        }
+        buffer.push(value);
+    }
+    return true;
+}
+
+template <class A> class memory_writer
+{
+  public:
+    explicit memory_writer(std::vector<uint8_t, A> &buffer) : buffer_(buffer)
+    {
+    }
+
+    size_t write(const void *data, size_t size, size_t count)
+    {
+        const auto bytes = static_cast<const uint8_t *>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size * count);
+        return count;
+    }
+
+  private:
+    std::vector<uint8_t, A> &buffer_;
+};
+
+class memory_reader
+{
+  public:
+    memory_reader(const uint8_t *data, size_t size) : data_(data), remaining_(size)
+    {
+    }
+
+    size_t read(void *data, size_t size, size_t count)
+    {
+        count = std::min(count, remaining_ / size);
+        memcpy(data, data_, size * count);
+        data_ += size * count;
+        remaining_ -= size * count;
+        return count;
+    }
+
+    size_t remaining() const
+    {
+        return remaining_;
+    }
+
+  private:
+    const uint8_t *data_;
+    size_t remaining_;
+};
+} // namespace esp32::binary_io
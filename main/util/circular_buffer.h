@@ -1,8 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <compare>
+#include <cstring>
+#include <iterator>
+#include <span>
 #include <stddef.h>
 #include <stdint.h>
 #include <type_traits>
+#include <utility>
 
 template <typename T, size_t S, typename IT = size_t>
     requires std::is_trivially_copyable_v<T>
@@ -104,11 +110,144 @@ class circular_buffer
      */
     void inline clear();
 
+    class const_iterator
+    {
+      public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+        const_iterator(const circular_buffer *buffer, IT index) : buffer_(buffer), index_(index)
+        {
+        }
+
+        reference operator*() const
+        {
+            return buffer_->at(index_);
+        }
+        pointer operator->() const
+        {
+            return &buffer_->at(index_);
+        }
+        reference operator[](difference_type n) const
+        {
+            return buffer_->at(index_ + n);
+        }
+
+        const_iterator &operator++()
+        {
+            ++index_;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            auto copy = *this;
+            ++index_;
+            return copy;
+        }
+        const_iterator &operator--()
+        {
+            --index_;
+            return *this;
+        }
+        const_iterator operator--(int)
+        {
+            auto copy = *this;
+            --index_;
+            return copy;
+        }
+        const_iterator &operator+=(difference_type n)
+        {
+            index_ += n;
+            return *this;
+        }
+        const_iterator &operator-=(difference_type n)
+        {
+            index_ -= n;
+            return *this;
+        }
+        friend const_iterator operator+(const_iterator it, difference_type n)
+        {
+            return it += n;
+        }
+        friend const_iterator operator+(difference_type n, const_iterator it)
+        {
+            return it += n;
+        }
+        friend const_iterator operator-(const_iterator it, difference_type n)
+        {
+            return it -= n;
+        }
+        friend difference_type operator-(const const_iterator &a, const const_iterator &b)
+        {
+            return static_cast<difference_type>(a.index_) - static_cast<difference_type>(b.index_);
+        }
+
+        bool operator==(const const_iterator &other) const
+        {
+            return index_ == other.index_;
+        }
+        auto operator<=>(const const_iterator &other) const
+        {
+            return index_ <=> other.index_;
+        }
+
+      private:
+        const circular_buffer *buffer_{nullptr};
+        IT index_{0};
+    };
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, count_);
+    }
+
+    /**
+     * Contents as two contiguous segments, oldest first. The second one is empty unless the data wraps.
+     */
+    std::pair<std::span<const T>, std::span<const T>> as_spans() const;
+
+    /**
+     * Copies `count` elements starting at `index` into `destination` with at most two memcpy.
+     * Returns the number of elements copied, which is less than `count` if the buffer holds fewer.
+     */
+    IT copy_to(T *destination, IT index, IT count) const;
+
   private:
     T buffer_[S]{};
     T *head_{};
     T *tail_{};
     IT count_{};
+
+    static constexpr bool is_power_of_two = (S & (S - 1)) == 0;
+
+    static constexpr size_t wrap(size_t position)
+    {
+        if constexpr (is_power_of_two)
+        {
+            return position & (S - 1);
+        }
+        else
+        {
+            return position % S;
+        }
+    }
+
+    /**
+     * Unchecked access, index must be less than `size()`
+     */
+    const T &at(IT index) const
+    {
+        return buffer_[wrap(head_ - buffer_ + index)];
+    }
 };
 
 template <typename T, size_t S, typename IT> constexpr circular_buffer<T, S, IT>::circular_buffer() : head_(buffer_), tail_(buffer_), count_(0)
@@ -205,7 +344,7 @@ template <typename T, size_t S, typename IT> T circular_buffer<T, S, IT>::operat
 {
     if (index >= count_)
         return *tail_;
-    return *(buffer_ + ((head_ - buffer_ + index) % capacity));
+    return at(index);
 }
 
 template <typename T, size_t S, typename IT> IT inline circular_buffer<T, S, IT>::size() const
@@ -232,4 +371,29 @@ template <typename T, size_t S, typename IT> void inline circular_buffer<T, S, I
 {
     head_ = tail_ = buffer_;
     count_ = 0;
-}
\ No newline at end of file
+}
+
+template <typename T, size_t S, typename IT>
+std::pair<std::span<const T>, std::span<const T>> circular_buffer<T, S, IT>::as_spans() const
+{
+    // count is read once so that spans stay in bounds when read while being written under a seqlock
+    const size_t count = std::min<size_t>(count_, S);
+    const size_t head = head_ - buffer_;
+    const size_t first = std::min<size_t>(count, S - head);
+    return {std::span<const T>(buffer_ + head, first), std::span<const T>(buffer_, count - first)};
+}
+
+template <typename T, size_t S, typename IT> IT circular_buffer<T, S, IT>::copy_to(T *destination, IT index, IT count) const
+{
+    if (index >= count_)
+    {
+        return 0;
+    }
+
+    count = std::min<IT>(count, count_ - index);
+    const size_t start = wrap(head_ - buffer_ + index);
+    const size_t first = std::min<size_t>(count, S - start);
+    memcpy(destination, buffer_ + start, first * sizeof(T));
+    memcpy(destination + first, buffer_, (count - first) * sizeof(T));
+    return count;
+}
@@ -0,0 +1,342 @@
+#pragma once
+
+#include "util/binary_io.h"
+#include "util/circular_buffer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Ring of compressed float samples. Values are quantized to a fixed step and stored as zigzag
+ * varint deltas with run length tokens for repeated values, packed into fixed size blocks.
+ * NaN values are gaps, stored as a token of 1 which would otherwise be an empty run.
+ * Sealed blocks are immutable, only the head block is appended to. When the ring is full the
+ * oldest sealed block is dropped.
+ * Values are exact as long as they are multiples of the quantization step.
+ */
+template <uint16_t block_sizeT, uint16_t block_countT>
+    requires(block_countT > 1)
+class compressed_float_ring
+{
+  public:
+    static constexpr size_t memory_size = block_sizeT * block_countT;
+
+    void set_quantization_step(float step)
+    {
+        quantization_step_ = step;
+        clear();
+    }
+
+    float get_quantization_step() const
+    {
+        return quantization_step_;
+    }
+
+    /**
+     * Pushes `count` copies of the value, repeats are O(1)
+     */
+    void push(float value, uint32_t count = 1)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // a gap keeps the last value so that the value after it is still a delta
+        const bool gap = std::isnan(value);
+        const int32_t quantized = gap ? last_quantized_ : std::lround(value / quantization_step_);
+        total_count_ += count;
+
+        if (head_.count == 0)
+        {
+            start_block(quantized, gap, count);
+            return;
+        }
+
+        if (gap == last_gap_ && quantized == last_quantized_)
+        {
+            head_.trailing_run += count;
+            head_.count += count;
+            return;
+        }
+
+        const uint32_t run_token = (head_.trailing_run << 1) | 1;
+        const uint32_t value_token = gap ? gap_token : zigzag(quantized - last_quantized_) << 1;
+        const size_t needed = (head_.trailing_run ? varint_size(run_token) : 0) + varint_size(value_token);
+
+        if (head_.length + needed > block_sizeT)
+        {
+            seal();
+            start_block(quantized, gap, count);
+            return;
+        }
+
+        if (head_.trailing_run)
+        {
+            write_varint(run_token);
+        }
+        write_varint(value_token);
+        head_.trailing_run = count - 1;
+        head_.count += count;
+        last_quantized_ = quantized;
+        last_gap_ = gap;
+    }
+
+    void clear()
+    {
+        sealed_.clear();
+        head_ = {};
+        total_count_ = 0;
+    }
+
+    size_t size() const
+    {
+        return total_count_;
+    }
+
+    /**
+     * Bytes of encoded data currently in use
+     */
+    size_t encoded_size() const
+    {
+        size_t size = head_.length;
+        for (size_t i = 0; i < sealed_.size(); i++)
+        {
+            size += sealed_[i].length;
+        }
+        return size;
+    }
+
+    /**
+     * Calls `callback(float)` for the newest `count` values, oldest first.
+     * Never calls back more than `count` times or reads outside a block, even if the ring is
+     * modified while being read.
+     */
+    template <class F> void for_each_newest(size_t count, F &&callback) const
+    {
+        size_t skip = total_count_ > count ? total_count_ - count : 0;
+        for (size_t i = 0; i < sealed_.size() && count; i++)
+        {
+            const auto &block = sealed_[i];
+            if (skip >= block.count)
+            {
+                skip -= block.count;
+                continue;
+            }
+            decode(block, skip, count, callback);
+            skip = 0;
+        }
+
+        if (head_.count && count)
+        {
+            decode(head_, skip, count, callback);
+        }
+    }
+
+    template <class S> bool save(S &stream) const
+    {
+        using namespace esp32::binary_io;
+        if (!write(stream, quantization_step_) || !write(stream, last_quantized_) || !write(stream, last_gap_) || !write(stream, sealed_.size()))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < sealed_.size(); i++)
+        {
+            if (!save_block(stream, sealed_[i]))
+            {
+                return false;
+            }
+        }
+        return save_block(stream, head_);
+    }
+
+    /**
+     * Fails if the data was saved with a different quantization step
+     */
+    template <class S> bool load(S &stream)
+    {
+        using namespace esp32::binary_io;
+        clear();
+
+        float quantization_step;
+        if (!read(stream, quantization_step) || quantization_step != quantization_step_ || !read(stream, last_quantized_) || !read(stream, last_gap_))
+        {
+            return false;
+        }
+
+        typename decltype(sealed_)::index_t sealed_count;
+        if (!read(stream, sealed_count) || sealed_count > sealed_.capacity)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < sealed_count; i++)
+        {
+            block value{};
+            if (!load_block(stream, value))
+            {
+                clear();
+                return false;
+            }
+            sealed_.push(value);
+            total_count_ += value.count;
+        }
+
+        if (!load_block(stream, head_))
+        {
+            clear();
+            return false;
+        }
+        total_count_ += head_.count;
+        return true;
+    }
+
+  private:
+    typedef struct
+    {
+        int32_t first;
+        bool first_gap;
+        uint32_t count;
+        uint32_t trailing_run; // repeats of the last value not yet written as token
+        uint16_t length;
+        std::array<uint8_t, block_sizeT> data;
+    } block;
+
+    circular_buffer<block, block_countT - 1> sealed_;
+    block head_{};
+    int32_t last_quantized_{0};
+    bool last_gap_{false};
+    size_t total_count_{0};
+    float quantization_step_{1};
+
+    static constexpr uint32_t gap_token = 1;
+
+    void start_block(int32_t quantized, bool gap, uint32_t count)
+    {
+        head_.first = quantized;
+        head_.first_gap = gap;
+        head_.count = count;
+        head_.trailing_run = count - 1;
+        last_quantized_ = quantized;
+        last_gap_ = gap;
+    }
+
+    void seal()
+    {
+        if (sealed_.is_full())
+        {
+            total_count_ -= sealed_.first().count;
+        }
+        sealed_.push(head_);
+        head_ = {};
+    }
+
+    template <class S> static bool save_block(S &stream, const block &value)
+    {
+        using namespace esp32::binary_io;
+        // may be read while being written under a seqlock, so never write more than the block holds
+        const uint16_t length = std::min<uint16_t>(value.length, block_sizeT);
+        return write(stream, value.first) && write(stream, value.first_gap) && write(stream, value.count) && write(stream, value.trailing_run) &&
+               write(stream, length) && stream.write(value.data.data(), 1, length) == length;
+    }
+
+    template <class S> static bool load_block(S &stream, block &value)
+    {
+        using namespace esp32::binary_io;
+        value = {};
+        return read(stream, value.first) && read(stream, value.first_gap) && read(stream, value.count) && read(stream, value.trailing_run) &&
+               read(stream, value.length) &&
+               value.length <= block_sizeT && stream.read(value.data.data(), 1, value.length) == value.length;
+    }
+
+    void write_varint(uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            head_.data[head_.length++] = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        head_.data[head_.length++] = static_cast<uint8_t>(value);
+    }
+
+    template <class F> void decode(const block &block, size_t skip, size_t &remaining, F &&callback) const
+    {
+        int32_t quantized = block.first;
+        bool gap = block.first_gap;
+        const auto emit = [&](uint32_t repeat) {
+            if (skip >= repeat)
+            {
+                skip -= repeat;
+                return;
+            }
+            const float value = gap ? NAN : quantized * quantization_step_;
+            for (auto i = skip; i < repeat && remaining; i++, remaining--)
+            {
+                callback(value);
+            }
+            skip = 0;
+        };
+
+        emit(1);
+
+        const uint16_t length = std::min<uint16_t>(block.length, block_sizeT);
+        uint16_t position = 0;
+        while (position < length && remaining)
+        {
+            uint32_t token = 0;
+            uint8_t shift = 0;
+            uint8_t byte;
+            do
+            {
+                byte = block.data[position++];
+                token |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                shift += 7;
+            } while ((byte & 0x80) && position < length && shift < 32);
+
+            if (token == gap_token)
+            {
+                gap = true;
+                emit(1);
+            }
+            else if (token & 1)
+            {
+                emit(token >> 1);
+            }
+            else
+            {
+                quantized += unzigzag(token >> 1);
+                gap = false;
+                emit(1);
+            }
+        }
+
+        if (block.trailing_run)
+        {
+            emit(block.trailing_run);
+        }
+    }
+
+    static constexpr uint32_t zigzag(int32_t value)
+    {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static constexpr int32_t unzigzag(uint32_t value)
+    {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    static constexpr size_t varint_size(uint32_t value)
+    {
+        size_t size = 1;
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+};
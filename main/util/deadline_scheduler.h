@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <stdint.h>
+#include <utility>
+
+namespace esp32
+{
+/**
+ * Min-heap of deadlines for up to `countT` ids. Times are wrapping milliseconds as returned by esp32::millis(),
+ * deadlines must be within 24 days of each other.
+ */
+template <class T, uint8_t countT> class deadline_scheduler
+{
+  public:
+    void schedule(T id, uint32_t deadline)
+    {
+        entries_[size_++] = entry{deadline, id};
+        std::push_heap(entries_.begin(), entries_.begin() + size_, later);
+    }
+
+    /**
+     * Removes the entry of `id`, returns false if it has none
+     */
+    bool cancel(T id)
+    {
+        const auto end = entries_.begin() + size_;
+        const auto found = std::find_if(entries_.begin(), end, [id](const entry &entry) { return entry.id == id; });
+        if (found == end)
+        {
+            return false;
+        }
+
+        *found = entries_[--size_];
+        std::make_heap(entries_.begin(), entries_.begin() + size_, later);
+        return true;
+    }
+
+    /**
+     * Milliseconds until the earliest deadline, 0 if it is due
+     */
+    std::optional<uint32_t> time_to_next(uint32_t now) const
+    {
+        if (size_ == 0)
+        {
+            return std::nullopt;
+        }
+        return std::max<int32_t>(0, static_cast<int32_t>(entries_[0].deadline - now));
+    }
+
+    /**
+     * Removes the earliest entry if it is due, returns the id and its deadline
+     */
+    std::optional<std::pair<T, uint32_t>> pop_due(uint32_t now)
+    {
+        if (time_to_next(now).value_or(1) != 0)
+        {
+            return std::nullopt;
+        }
+
+        std::pop_heap(entries_.begin(), entries_.begin() + size_, later);
+        const auto &top = entries_[--size_];
+        return std::pair<T, uint32_t>{top.id, top.deadline};
+    }
+
+    uint8_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    struct entry
+    {
+        uint32_t deadline;
+        T id;
+    };
+
+    std::array<entry, countT> entries_{};
+    uint8_t size_{0};
+
+    // heap keeps the largest on top, so the earliest has to compare as largest
+    static bool later(const entry &entry1, const entry &entry2)
+    {
+        return static_cast<int32_t>(entry1.deadline - entry2.deadline) > 0;
+    }
+};
+} // namespace esp32
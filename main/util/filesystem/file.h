@@ -30,6 +30,12 @@ class file : esp32::noncopyable
         return fread(buffer, size, count, file_);
     }
 
+    // nullptr at the end of the file
+    char *read_line(char *buffer, int size)
+    {
+        return fgets(buffer, size, file_);
+    }
+
     size_t write(const void *buffer, size_t size, size_t count)
     {
         return fwrite(buffer, size, count, file_);
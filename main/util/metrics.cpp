@@ -0,0 +1,210 @@
+#include "metrics.h"
+#include "util/async_web_server/http_response.h"
+#include "util/psram_allocator.h"
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+namespace esp32
+{
+namespace metrics
+{
+void writer::family(std::string_view name, std::string_view help, metric_type type)
+{
+    response_.write("# HELP ");
+    response_.write(name);
+    response_.write(" ");
+    response_.write(help);
+    response_.write("\n# TYPE ");
+    response_.write(name);
+    switch (type)
+    {
+    case metric_type::counter:
+        response_.write(" counter\n");
+        break;
+    case metric_type::gauge:
+        response_.write(" gauge\n");
+        break;
+    case metric_type::histogram:
+        response_.write(" histogram\n");
+        break;
+    }
+}
+
+void writer::sample(std::string_view name, std::initializer_list<label> labels, uint64_t value)
+{
+    write_series(name, {}, labels);
+    char buffer[24];
+    const auto length = snprintf(buffer, sizeof(buffer), " %" PRIu64 "\n", value);
+    response_.write({buffer, static_cast<size_t>(length)});
+}
+
+void writer::sample(std::string_view name, std::initializer_list<label> labels, double value)
+{
+    write_series(name, {}, labels);
+    char buffer[32];
+    const auto length = snprintf(buffer, sizeof(buffer), " %.9g\n", value);
+    response_.write({buffer, static_cast<size_t>(length)});
+}
+
+void writer::bucket(std::string_view name, std::initializer_list<label> labels, double limit, uint64_t count)
+{
+    char le[24];
+    if (limit < 0)
+    {
+        strcpy(le, "+Inf");
+    }
+    else
+    {
+        snprintf(le, sizeof(le), "%.9g", limit);
+    }
+
+    write_series(name, "_bucket", labels, {"le", le});
+    char buffer[24];
+    const auto length = snprintf(buffer, sizeof(buffer), " %" PRIu64 "\n", count);
+    response_.write({buffer, static_cast<size_t>(length)});
+}
+
+void writer::suffixed_sample(std::string_view name, std::string_view suffix, std::initializer_list<label> labels, uint64_t value)
+{
+    write_series(name, suffix, labels);
+    char buffer[24];
+    const auto length = snprintf(buffer, sizeof(buffer), " %" PRIu64 "\n", value);
+    response_.write({buffer, static_cast<size_t>(length)});
+}
+
+void writer::suffixed_sample(std::string_view name, std::string_view suffix, std::initializer_list<label> labels, double value)
+{
+    write_series(name, suffix, labels);
+    char buffer[32];
+    const auto length = snprintf(buffer, sizeof(buffer), " %.9g\n", value);
+    response_.write({buffer, static_cast<size_t>(length)});
+}
+
+void writer::write_series(std::string_view name, std::string_view suffix, std::initializer_list<label> labels, label extra)
+{
+    response_.write(name);
+    response_.write(suffix);
+
+    bool first = true;
+    const auto write_label = [this, &first](const label &label) {
+        response_.write(first ? "{" : ",");
+        response_.write(label.name);
+        response_.write("=\"");
+        write_label_value(label.value);
+        response_.write("\"");
+        first = false;
+    };
+
+    for (auto &&label : labels)
+    {
+        write_label(label);
+    }
+
+    // the le label of histogram buckets
+    if (!extra.name.empty())
+    {
+        write_label(extra);
+    }
+
+    if (!first)
+    {
+        response_.write("}");
+    }
+}
+
+void writer::write_label_value(std::string_view value)
+{
+    for (const auto c : value)
+    {
+        switch (c)
+        {
+        case '\\':
+            response_.write("\\\\");
+            break;
+        case '"':
+            response_.write("\\\"");
+            break;
+        case '\n':
+            response_.write("\\n");
+            break;
+        default:
+            response_.write(static_cast<uint8_t>(c));
+            break;
+        }
+    }
+}
+
+/**
+ * Heap and FreeRTOS task metrics, read from the system while scraping
+ */
+class system_collector final : collector
+{
+  public:
+    void collect(writer &writer) const override
+    {
+        collect_heap(writer);
+        collect_tasks(writer);
+    }
+
+  private:
+    static void collect_heap(writer &writer)
+    {
+        constexpr label internal{"memory", "internal"};
+        constexpr label spiram{"memory", "spiram"};
+        constexpr auto internal_caps = MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL;
+
+        writer.family("heap_free_bytes", "Free heap", metric_type::gauge);
+        writer.sample("heap_free_bytes", {internal}, static_cast<uint64_t>(heap_caps_get_free_size(internal_caps)));
+        writer.sample("heap_free_bytes", {spiram}, static_cast<uint64_t>(heap_caps_get_free_size(MALLOC_CAP_SPIRAM)));
+
+        writer.family("heap_largest_free_block_bytes", "Largest free heap block", metric_type::gauge);
+        writer.sample("heap_largest_free_block_bytes", {internal}, static_cast<uint64_t>(heap_caps_get_largest_free_block(internal_caps)));
+        writer.sample("heap_largest_free_block_bytes", {spiram}, static_cast<uint64_t>(heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM)));
+
+        writer.family("heap_minimum_free_bytes", "Lowest free heap since boot", metric_type::gauge);
+        writer.sample("heap_minimum_free_bytes", {internal}, static_cast<uint64_t>(heap_caps_get_minimum_free_size(internal_caps)));
+        writer.sample("heap_minimum_free_bytes", {spiram}, static_cast<uint64_t>(heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM)));
+    }
+
+    static void collect_tasks(writer &writer)
+    {
+        // a few spare entries for tasks created in between
+        auto num_of_tasks = uxTaskGetNumberOfTasks() + 4;
+        const std::unique_ptr<TaskStatus_t[], esp32::psram::deleter> tasks(
+            reinterpret_cast<TaskStatus_t *>(heap_caps_calloc(num_of_tasks, sizeof(TaskStatus_t), MALLOC_CAP_SPIRAM)));
+        if (!tasks)
+        {
+            return;
+        }
+
+        num_of_tasks = uxTaskGetSystemState(tasks.get(), num_of_tasks, nullptr);
+
+#if configGENERATE_RUN_TIME_STATS
+        // run time stats use esp_timer, in microseconds. The 32 bit counter wraps after about 71 minutes,
+        // which rate() takes as a counter reset
+        writer.family("task_cpu_seconds_total", "CPU time of a FreeRTOS task", metric_type::counter);
+        for (UBaseType_t i = 0; i < num_of_tasks; i++)
+        {
+            writer.sample("task_cpu_seconds_total", {{"task", tasks[i].pcTaskName}}, tasks[i].ulRunTimeCounter / 1e6);
+        }
+#endif
+
+        // stack is in bytes on esp-idf
+        writer.family("task_stack_high_water_mark_bytes", "Least free stack of a FreeRTOS task since it started", metric_type::gauge);
+        for (UBaseType_t i = 0; i < num_of_tasks; i++)
+        {
+            writer.sample("task_stack_high_water_mark_bytes", {{"task", tasks[i].pcTaskName}},
+                          static_cast<uint64_t>(tasks[i].usStackHighWaterMark));
+        }
+    }
+};
+
+static system_collector system_metrics;
+
+} // namespace metrics
+} // namespace esp32
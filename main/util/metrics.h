@@ -0,0 +1,201 @@
+#pragma once
+
+#include "util/noncopyable.h"
+#include "util/seqlock.h"
+#include <array>
+#include <atomic>
+#include <initializer_list>
+#include <mutex>
+#include <stdint.h>
+#include <string_view>
+
+namespace esp32
+{
+class chunked_response;
+
+namespace metrics
+{
+enum class metric_type : uint8_t
+{
+    counter,
+    gauge,
+    histogram,
+};
+
+struct label
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+class counter : esp32::noncopyable
+{
+  public:
+    void add(uint32_t value = 1)
+    {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint32_t get() const
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic_uint32_t value_{0};
+};
+
+class gauge : esp32::noncopyable
+{
+  public:
+    void set(int32_t value)
+    {
+        value_.store(value, std::memory_order_relaxed);
+    }
+
+    void add(int32_t value)
+    {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    int32_t get() const
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic_int32_t value_{0};
+};
+
+/**
+ * Fixed bucket histogram for a single writer. Values are integers, usually microseconds, the last bucket counts
+ * everything above the limits. The sum is 64 bit, which is not atomic on the ESP32, so buckets and sum are
+ * written under a seqlock and read together: the sum always belongs to the counts it is exposed with.
+ */
+template <uint32_t... limits> class histogram : esp32::noncopyable
+{
+  public:
+    static constexpr std::array<uint32_t, sizeof...(limits)> bucket_limits{limits...};
+    static constexpr size_t bucket_count = bucket_limits.size() + 1;
+
+    struct values
+    {
+        std::array<uint32_t, bucket_count> buckets;
+        uint64_t sum;
+    };
+
+    void add(uint32_t value)
+    {
+        size_t i = 0;
+        while (i < bucket_limits.size() && value > bucket_limits[i])
+        {
+            i++;
+        }
+
+        std::lock_guard<esp32::seqlock> lock(lock_);
+        buckets_[i]++;
+        sum_ += value;
+    }
+
+    values get() const
+    {
+        return lock_.read([this] { return values{buckets_, sum_}; });
+    }
+
+  private:
+    esp32::seqlock lock_;
+    std::array<uint32_t, bucket_count> buckets_{};
+    uint64_t sum_{0};
+};
+
+/**
+ * Writes the text exposition format (version 0.0.4) into a chunked response. Only used while scraping,
+ * formatting goes through a small stack buffer.
+ */
+class writer : esp32::noncopyable
+{
+  public:
+    explicit writer(esp32::chunked_response &response) : response_(response)
+    {
+    }
+
+    void family(std::string_view name, std::string_view help, metric_type type);
+
+    void sample(std::string_view name, std::initializer_list<label> labels, uint64_t value);
+    void sample(std::string_view name, std::initializer_list<label> labels, double value);
+
+    void sample(std::string_view name, std::initializer_list<label> labels, const metrics::counter &counter)
+    {
+        sample(name, labels, static_cast<uint64_t>(counter.get()));
+    }
+
+    void sample(std::string_view name, std::initializer_list<label> labels, const metrics::gauge &gauge)
+    {
+        sample(name, labels, static_cast<double>(gauge.get()));
+    }
+
+    /**
+     * Cumulative buckets, sum and count of a histogram, `scale` converts its values to the exposed unit
+     */
+    template <uint32_t... limits>
+    void histogram(std::string_view name, std::initializer_list<label> labels, const metrics::histogram<limits...> &histogram, double scale)
+    {
+        using histogram_t = metrics::histogram<limits...>;
+        const auto values = histogram.get();
+        uint64_t count = 0;
+        for (size_t i = 0; i < histogram_t::bucket_count; i++)
+        {
+            count += values.buckets[i];
+            bucket(name, labels, i < histogram_t::bucket_limits.size() ? histogram_t::bucket_limits[i] * scale : -1, count);
+        }
+        suffixed_sample(name, "_sum", labels, values.sum * scale);
+        suffixed_sample(name, "_count", labels, count);
+    }
+
+  private:
+    esp32::chunked_response &response_;
+
+    void bucket(std::string_view name, std::initializer_list<label> labels, double limit, uint64_t count);
+    void suffixed_sample(std::string_view name, std::string_view suffix, std::initializer_list<label> labels, uint64_t value);
+    void suffixed_sample(std::string_view name, std::string_view suffix, std::initializer_list<label> labels, double value);
+    void write_series(std::string_view name, std::string_view suffix, std::initializer_list<label> labels, label extra = {});
+    void write_label_value(std::string_view value);
+};
+
+/**
+ * Source of metrics for /metrics. Collectors link themselves into a global list when constructed and
+ * are never unlinked, so they must live as long as the program, like the singletons which own them.
+ * collect runs on the http server task while scraping, the values it reads are kept up to date with
+ * atomics by the owning subsystem.
+ */
+class collector : esp32::noncopyable
+{
+  public:
+    virtual void collect(writer &writer) const = 0;
+
+    static void collect_all(writer &writer)
+    {
+        for (auto current = head_.load(std::memory_order_acquire); current; current = current->next_)
+        {
+            current->collect(writer);
+        }
+    }
+
+  protected:
+    collector()
+    {
+        next_ = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(next_, this, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    ~collector() = default;
+
+  private:
+    collector *next_{nullptr};
+    static inline std::atomic<collector *> head_{nullptr};
+};
+
+} // namespace metrics
+} // namespace esp32
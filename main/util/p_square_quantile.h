@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <stdint.h>
+
+/**
+ * Streaming quantile estimate with the P² algorithm (Jain & Chlamtac), constant memory and O(1) per value.
+ * Five markers track the minimum, p/2, p, (1+p)/2 quantiles and the maximum, the middle one is the estimate.
+ */
+class p_square_quantile
+{
+  public:
+    explicit p_square_quantile(float quantile) : quantile_(quantile)
+    {
+        clear();
+    }
+
+    void add(float value)
+    {
+        if (count_ < marker_count)
+        {
+            heights_[count_++] = value;
+            if (count_ == marker_count)
+            {
+                std::sort(heights_.begin(), heights_.end());
+            }
+            return;
+        }
+        count_++;
+
+        uint8_t cell;
+        if (value < heights_[0])
+        {
+            heights_[0] = value;
+            cell = 0;
+        }
+        else if (value >= heights_[marker_count - 1])
+        {
+            heights_[marker_count - 1] = value;
+            cell = marker_count - 2;
+        }
+        else
+        {
+            cell = 0;
+            while (value >= heights_[cell + 1])
+            {
+                cell++;
+            }
+        }
+
+        for (auto i = cell + 1; i < marker_count; i++)
+        {
+            positions_[i]++;
+        }
+        for (auto i = 0; i < marker_count; i++)
+        {
+            desired_positions_[i] += increments_[i];
+        }
+
+        for (auto i = 1; i < marker_count - 1; i++)
+        {
+            const auto delta = desired_positions_[i] - positions_[i];
+            if ((delta >= 1 && positions_[i + 1] - positions_[i] > 1) || (delta <= -1 && positions_[i - 1] - positions_[i] < -1))
+            {
+                const int8_t direction = delta > 0 ? 1 : -1;
+                const auto height = parabolic(i, direction);
+                if (heights_[i - 1] < height && height < heights_[i + 1])
+                {
+                    heights_[i] = height;
+                }
+                else
+                {
+                    heights_[i] = linear(i, direction);
+                }
+                positions_[i] += direction;
+            }
+        }
+    }
+
+    /**
+     * Exact for less than five values
+     */
+    std::optional<float> get() const
+    {
+        const auto count = std::min<uint32_t>(count_, marker_count);
+        if (count == 0)
+        {
+            return std::nullopt;
+        }
+        if (count < marker_count)
+        {
+            auto values = heights_;
+            std::sort(values.begin(), values.begin() + count);
+            return values[std::lround(quantile_ * (count - 1))];
+        }
+        return heights_[2];
+    }
+
+    uint32_t count() const
+    {
+        return count_;
+    }
+
+    void clear()
+    {
+        count_ = 0;
+        heights_ = {};
+        positions_ = {1, 2, 3, 4, 5};
+        desired_positions_ = {1, 1 + 2 * quantile_, 1 + 4 * quantile_, 3 + 2 * quantile_, 5};
+        increments_ = {0, quantile_ / 2, quantile_, (1 + quantile_) / 2, 1};
+    }
+
+  private:
+    static constexpr uint8_t marker_count = 5;
+
+    float quantile_;
+    uint32_t count_;
+    std::array<float, marker_count> heights_;
+    std::array<int32_t, marker_count> positions_;
+    std::array<float, marker_count> desired_positions_;
+    std::array<float, marker_count> increments_;
+
+    float parabolic(int i, int8_t direction) const
+    {
+        const float n_prev = positions_[i - 1];
+        const float n = positions_[i];
+        const float n_next = positions_[i + 1];
+        return heights_[i] + direction / (n_next - n_prev) *
+                                 ((n - n_prev + direction) * (heights_[i + 1] - heights_[i]) / (n_next - n) +
+                                  (n_next - n - direction) * (heights_[i] - heights_[i - 1]) / (n - n_prev));
+    }
+
+    float linear(int i, int8_t direction) const
+    {
+        return heights_[i] + direction * (heights_[i + direction] - heights_[i]) / (positions_[i + direction] - positions_[i]);
+    }
+};
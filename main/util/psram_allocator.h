@@ -21,6 +21,10 @@ template <typename T> class allocator
     allocator() = default;
     ~allocator() = default;
 
+    template <class U> allocator(const allocator<U> &)
+    {
+    }
+
     template <class U> struct rebind
     {
         typedef allocator<U> other;
@@ -60,6 +64,16 @@ template <typename T> class allocator
     }
 };
 
+template <class T1, class T2> bool operator==(const allocator<T1> &, const allocator<T2> &)
+{
+    return true;
+}
+
+template <class T1, class T2> bool operator!=(const allocator<T1> &, const allocator<T2> &)
+{
+    return false;
+}
+
 struct deleter
 {
     void operator()(void *p) const
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "util/noncopyable.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdint.h>
+
+namespace esp32
+{
+/**
+ * Sequence lock for a single writer and many readers. The writer never waits, readers never block it and
+ * retry if a write happened while they were reading. Readers can see torn data before the retry, so code
+ * run under `read()` must stay in bounds whatever it reads.
+ * `lock()`/`unlock()` mark the write section so that std::lock_guard can be used by the writer.
+ */
+class seqlock final : esp32::noncopyable
+{
+  public:
+    void lock()
+    {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void unlock()
+    {
+        sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    template <class F> auto read(F &&ftn) const
+    {
+        while (true)
+        {
+            const auto sequence = read_begin();
+            auto result = ftn();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == sequence)
+            {
+                return result;
+            }
+        }
+    }
+
+    /**
+     * Changes on every write, odd while a write is in progress
+     */
+    uint32_t sequence() const
+    {
+        return sequence_.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::atomic_uint32_t sequence_{0}; // odd while a write is in progress
+
+    uint32_t read_begin() const
+    {
+        uint8_t spins = 0;
+        uint32_t sequence;
+        while ((sequence = sequence_.load(std::memory_order_acquire)) & 1)
+        {
+            // writer can be preempted by a higher priority reader on the same core
+            if (++spins == 0)
+            {
+                vTaskDelay(1);
+            }
+        }
+        return sequence;
+    }
+};
+} // namespace esp32
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "hardware/sensors/sensor_history.h"
+#include "util/binary_io.h"
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Binary form of a sensor history snapshot, served by /api/sensor/history/get?format=bin and decoded by
+ * decodeSensorHistory in static/web/js/sensor_history.js. Little endian:
+ *
+ *   u8 version, u8 flags (bit 0 stats, bit 1 percentiles), u16 count, u32 interval seconds, f32 scale,
+ *   f32 min, max, mean, f32 p50, p95, p99, then the tokens
+ *
+ * Values are quantized to `scale` and written as varint tokens, the same as compressed_float_ring:
+ * an even token is the zigzag delta from the previous value (0 for the first), an odd token repeats the
+ * previous value token >> 1 times and a token of 1 is a gap, a point without value. Deltas after a gap are
+ * from the last value before it. Absent stats and percentiles are NaN.
+ */
+class sensor_history_encoder
+{
+  public:
+    static constexpr uint8_t version = 2;
+    static constexpr uint8_t stats_flag = 0x01;
+    static constexpr uint8_t percentiles_flag = 0x02;
+    static constexpr size_t header_size = 36;
+
+    template <class A> static void encode(const sensor_history::sensor_history_snapshot &snapshot, float scale, std::vector<uint8_t, A> &buffer)
+    {
+        using namespace esp32::binary_io;
+        static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+        // most deltas fit a byte
+        buffer.clear();
+        buffer.reserve(header_size + snapshot.history.size() + 8);
+
+        const uint8_t flags = (snapshot.stat.has_value() ? stats_flag : 0) | (snapshot.percentiles.has_value() ? percentiles_flag : 0);
+        const sensor_history_stats stats = snapshot.stat.value_or(sensor_history_stats{NAN, NAN, NAN});
+        const sensor_history_percentiles percentiles = snapshot.percentiles.value_or(sensor_history_percentiles{NAN, NAN, NAN});
+
+        memory_writer writer(buffer);
+        write(writer, version);
+        write(writer, flags);
+        write(writer, static_cast<uint16_t>(snapshot.history.size()));
+        write(writer, snapshot.interval_seconds);
+        write(writer, scale);
+        write(writer, stats.min);
+        write(writer, stats.max);
+        write(writer, stats.mean);
+        write(writer, percentiles.p50);
+        write(writer, percentiles.p95);
+        write(writer, percentiles.p99);
+
+        int32_t previous = 0;
+        bool previous_gap = false;
+        uint32_t run = 0;
+        for (const auto value : snapshot.history)
+        {
+            const bool gap = std::isnan(value);
+            const int32_t quantized = gap ? previous : std::lround(value / scale);
+            const int32_t delta = quantized - previous;
+            if (delta == 0 && gap == previous_gap && buffer.size() > header_size)
+            {
+                run++;
+                continue;
+            }
+
+            if (run)
+            {
+                write_varint(buffer, (run << 1) | 1);
+                run = 0;
+            }
+            write_varint(buffer, gap ? gap_token : zigzag(delta) << 1);
+            previous = quantized;
+            previous_gap = gap;
+        }
+
+        if (run)
+        {
+            write_varint(buffer, (run << 1) | 1);
+        }
+    }
+
+  private:
+    static constexpr uint32_t gap_token = 1;
+
+    template <class A> static void write_varint(std::vector<uint8_t, A> &buffer, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+
+    static constexpr uint32_t zigzag(int32_t value)
+    {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+};
@@ -10,6 +10,7 @@
 #include "generated/web/include/s.js.gz.h"
 #include "hardware/hardware.h"
 #include "hardware/sd_card.h"
+#include "hardware/sensors/sensor_device_stats.h"
 #include "logging/commands.h"
 #include "logging/logger.h"
 #include "logging/logging_tags.h"
@@ -23,14 +24,18 @@
 #include "util/finally.h"
 #include "util/hash/hash.h"
 #include "util/helper.h"
+#include "util/metrics.h"
 #include "util/misc.h"
 #include "util/ota.h"
 #include "util/psram_allocator.h"
+#include "web_server/sensor_history_encoder.h"
+#include <bitset>
 #include <dirent.h>
 #include <esp_log.h>
 #include <filesystem>
 #include <homekit/homekit_integration.h>
 #include <mbedtls/md.h>
+#include <span>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -46,6 +51,8 @@ static const char js_media_type[] = "text/javascript";
 static const char html_media_type[] = "text/html";
 static const char css_media_type[] = "text/css";
 static const char png_media_type[] = "image/png";
+static const char binary_media_type[] = "application/octet-stream";
+static const char metrics_media_type[] = "text/plain; version=0.0.4";
 
 static const char CookieHeader[] = "Cookie";
 static const char AuthCookieName[] = "ESPSESSIONID=";
@@ -134,7 +141,9 @@ void web_server::begin()
 
     add_handler_ftn<web_server, &web_server::handle_sensor_get>("/api/sensor/get", HTTP_GET);
     add_handler_ftn<web_server, &web_server::handle_sensor_stats>("/api/sensor/history/get", HTTP_GET);
+    add_handler_ftn<web_server, &web_server::handle_sensor_bulk_history>("/api/sensor/history/bulk", HTTP_GET);
     add_handler_ftn<web_server, &web_server::handle_information_get>("/api/information/get", HTTP_GET);
+    add_handler_ftn<web_server, &web_server::handle_sensor_device_stats_get>("/api/sensor/devices/get", HTTP_GET);
     add_handler_ftn<web_server, &web_server::handle_config_get>("/api/config/get", HTTP_GET);
     add_handler_ftn<web_server, &web_server::handle_homekit_info_get>("/api/homekit/get", HTTP_GET);
     add_handler_ftn<web_server, &web_server::handle_homekit_enable_pairing>("/api/homekit/enablepairing", HTTP_POST);
@@ -161,6 +170,8 @@ void web_server::begin()
     add_handler_ftn<web_server, &web_server::on_set_logging_level>("/api/log/loglevel", HTTP_POST);
     add_handler_ftn<web_server, &web_server::on_run_command>("/api/log/run", HTTP_POST);
 
+    add_handler_ftn<web_server, &web_server::handle_metrics>("/metrics", HTTP_GET);
+
     instance_sensor_change_event_.subscribe();
 }
 
@@ -192,6 +203,58 @@ void web_server::handle_information_get(esp32::http_request &request)
     send_table_response(request, ui_interface::information_type::system);
 }
 
+void web_server::handle_sensor_device_stats_get(esp32::http_request &request)
+{
+    ESP_LOGD(WEBSERVER_TAG, "/api/sensor/devices/get");
+    if (!check_authenticated(request))
+    {
+        return;
+    }
+
+    BasicJsonDocument<esp32::psram::json_allocator> json_document(8192);
+    auto root = json_document.to<JsonObject>();
+
+    auto bucket_limits = root.createNestedArray("latencyBucketLimitsUs");
+    for (const auto limit : latency_histogram::bucket_limits)
+    {
+        bucket_limits.add(limit);
+    }
+
+    const auto now = esp32::millis();
+    auto devices = root.createNestedArray("devices");
+    ui_interface_.for_each_sensor_device_stats([&](const sensor_device_stats &stats) {
+        auto obj = devices.createNestedObject();
+        obj["name"] = stats.get_name();
+        obj["reads"] = stats.get_reads();
+        obj["notReady"] = stats.get_not_ready();
+        obj["errors"] = stats.get_errors();
+        obj["nanValues"] = stats.get_nan_values();
+        obj["timeouts"] = stats.get_timeouts();
+        obj["stalls"] = stats.get_stalls();
+        obj["healthy"] = stats.is_healthy();
+        obj["transferErrors"] = stats.get_transfer_errors();
+
+        const auto last_error = stats.get_last_error();
+        if (last_error != ESP_OK)
+        {
+            obj["lastError"] = esp_err_to_name(last_error);
+            obj["lastErrorAgeMs"] = now - stats.get_last_error_time();
+        }
+
+        auto read_latency = obj.createNestedArray("readLatency");
+        auto transfer_latency = obj.createNestedArray("transferLatency");
+        const auto read_latency_values = stats.get_read_latency().get();
+        const auto transfer_latency_values = stats.get_transfer_latency().get();
+        for (auto i = 0; i < latency_histogram::bucket_count; i++)
+        {
+            read_latency.add(read_latency_values.buckets[i]);
+            transfer_latency.add(transfer_latency_values.buckets[i]);
+        }
+    });
+
+    send_json_response(request, json_document);
+}
+
 void web_server::handle_sensor_get(esp32::http_request &request)
 {
     ESP_LOGD(WEBSERVER_TAG, "/api/sensor/get");
@@ -221,6 +284,84 @@ void web_server::handle_sensor_get(esp32::http_request &request)
     send_json_response(request, json_document);
 }
 
+/**
+ * Writes stats, percentiles, interval and history members of a snapshot, history from point `first`. History longer
+ * than `points` is averaged over groups of consecutive values, the interval grows to match.
+ */
+static void write_sensor_history_json(esp32::chunked_response &response, const sensor_history::sensor_history_snapshot &snapshot, uint16_t points,
+                                      size_t first = 0)
+{
+    const std::span<const float> history(snapshot.history.data() + first, snapshot.history.size() - first);
+    const size_t group = (points && (history.size() > points)) ? (history.size() + points - 1) / points : 1;
+
+    BasicJsonDocument<esp32::psram::json_allocator> json_document(JSON_OBJECT_SIZE(3) + 2 * JSON_OBJECT_SIZE(3));
+
+    auto stats_json = json_document.createNestedObject("stats");
+    if (snapshot.stat.has_value())
+    {
+        auto &&stats = snapshot.stat.value();
+        stats_json["max"].set(stats.max);
+        stats_json["min"].set(stats.min);
+        stats_json["mean"].set(stats.mean);
+    }
+    else
+    {
+        stats_json["max"].set(nullptr);
+        stats_json["min"].set(nullptr);
+        stats_json["mean"].set(nullptr);
+    }
+
+    auto percentiles_json = json_document.createNestedObject("percentiles");
+    if (snapshot.percentiles.has_value())
+    {
+        auto &&percentiles = snapshot.percentiles.value();
+        percentiles_json["p50"].set(percentiles.p50);
+        percentiles_json["p95"].set(percentiles.p95);
+        percentiles_json["p99"].set(percentiles.p99);
+    }
+    else
+    {
+        percentiles_json["p50"].set(nullptr);
+        percentiles_json["p95"].set(nullptr);
+        percentiles_json["p99"].set(nullptr);
+    }
+
+    json_document["interval"].set(snapshot.interval_seconds * group);
+
+    // the history array is streamed, only the rest is in the document
+    response.write("\"stats\":");
+    serializeJson(json_document["stats"], response);
+    response.write(",\"percentiles\":");
+    serializeJson(json_document["percentiles"], response);
+    response.write(",\"interval\":");
+    serializeJson(json_document["interval"], response);
+    response.write(",\"history\":[");
+
+    // groups end at the newest value, only the oldest one can be partial
+    std::array<char, 16> value_str;
+    size_t end = (history.size() % group) ? (history.size() % group) : group;
+    for (size_t begin = 0; begin < history.size(); begin = end, end += group)
+    {
+        // gaps are skipped, a group of only gaps is null
+        float sum = 0;
+        size_t count = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            if (!std::isnan(history[i]))
+            {
+                sum += history[i];
+                count++;
+            }
+        }
+        const auto value = count ? sum / count : NAN;
+        const auto length = std::isnan(value) ? snprintf(value_str.data(), value_str.size(), "null")
+                                              : snprintf(value_str.data(), value_str.size(), "%.7g", value);
+        response.write(begin ? "," : "");
+        response.write({value_str.data(), static_cast<size_t>(length)});
+    }
+    response.write("]");
+}
+
 void web_server::handle_sensor_stats(esp32::http_request &request)
 {
     ESP_LOGD(WEBSERVER_TAG, "api/sensor/history/get");
@@ -229,8 +370,12 @@ void web_server::handle_sensor_stats(esp32::http_request &request)
         return;
     }
 
-    const auto arguments = request.get_url_arguments({"id"});
+    const auto arguments = request.get_url_arguments({"id", "range", "format", "since", "points"});
     auto &&id_arg = arguments[0];
+    auto &&range_arg = arguments[1];
+    auto &&format_arg = arguments[2];
+    auto &&since_arg = arguments[3];
+    auto &&points_arg = arguments[4];
 
     auto id_arg_num = id_arg.has_value() ? esp32::string::parse_number<uint8_t>(id_arg.value()) : std::nullopt;
 
@@ -240,30 +385,177 @@ void web_server::handle_sensor_stats(esp32::http_request &request)
         return;
     }
 
+    const auto range_arg_num = range_arg.has_value() ? esp32::string::parse_number<uint32_t>(range_arg.value()) : std::nullopt;
+    if (range_arg.has_value() && (!range_arg_num.has_value() || (range_arg_num.value() == 0)))
+    {
+        log_and_send_error(request, HTTPD_400_BAD_REQUEST, "history range invalid");
+        return;
+    }
+
+    // more than the default points reads up to 12 hours at full resolution
+    const auto points_arg_num = points_arg.has_value() ? esp32::string::parse_number<uint16_t>(points_arg.value()) : std::nullopt;
+    if (points_arg.has_value() &&
+        (!points_arg_num.has_value() || (points_arg_num.value() == 0) || (points_arg_num.value() > sensor_history::max_full_resolution_points)))
+    {
+        log_and_send_error(request, HTTPD_400_BAD_REQUEST, "history points invalid");
+        return;
+    }
+    const auto points = points_arg_num.value_or(sensor_history::default_max_points);
+
+    const bool binary = format_arg.has_value() && (format_arg.value() == "bin");
+    if (format_arg.has_value() && !binary && (format_arg.value() != "json"))
+    {
+        log_and_send_error(request, HTTPD_400_BAD_REQUEST, "history format invalid");
+        return;
+    }
+
+    // cursor is epoch-interval-valid since-value count, a cursor of another boot, tier or cleared history gets the full history
+    std::optional<uint32_t> since_value_count;
+    uint32_t since_interval = 0;
+    uint32_t since_valid_since = 0;
+    if (since_arg.has_value())
+    {
+        unsigned long epoch, interval, valid_since, value_count;
+        int length = 0;
+        if (binary || (sscanf(since_arg->c_str(), "%lx-%lx-%lx-%lx%n", &epoch, &interval, &valid_since, &value_count, &length) != 4) ||
+            (static_cast<size_t>(length) != since_arg->size()))
+        {
+            log_and_send_error(request, HTTPD_400_BAD_REQUEST, "history since invalid");
+            return;
+        }
+
+        if (epoch == history_epoch_)
+        {
+            since_value_count = value_count;
+            since_interval = interval;
+            since_valid_since = valid_since;
+        }
+    }
+
     const auto id = static_cast<sensor_id_index>(id_arg_num.value());
-    const auto &sensor_detail_info = ui_interface_.get_sensor_detail_info(id);
+    const auto sensor_detail_info_handle =
+        ui_interface_.get_sensor_detail_info(id, range_arg_num.value_or(sensor_history::default_range_seconds), points);
+    auto &&sensor_detail_info = *sensor_detail_info_handle;
+
+    const auto cursor = esp32::string::sprintf("%lx-%lx-%lx-%lx", history_epoch_, sensor_detail_info.interval_seconds, sensor_detail_info.valid_since,
+                                               sensor_detail_info.value_count);
+    const auto etag = "\"" + cursor + "\"";
+    esp32::http_response not_modified_response(request);
+    if (not_modified_response.send_not_modified(etag))
+    {
+        return;
+    }
+
+    if (binary)
+    {
+        // same precision as the history keeps
+        const auto scale = get_sensor_definition(id).get_value_step() / 10;
+        std::vector<uint8_t, esp32::psram::allocator<uint8_t>> data;
+        sensor_history_encoder::encode(sensor_detail_info, scale, data);
+        esp32::array_response response(request, data, etag, false, binary_media_type);
+        response.send_response();
+        return;
+    }
 
-    BasicJsonDocument<esp32::psram::json_allocator> json_document(8 * 1024);
+    // points after the one holding the cursor value have changed, a history cleared since or another tier needs all of them
+    const bool delta = since_value_count.has_value() && (since_interval == sensor_detail_info.interval_seconds) &&
+                       (since_valid_since == sensor_detail_info.valid_since) && (since_value_count.value() >= sensor_detail_info.valid_since) &&
+                       (since_value_count.value() <= sensor_detail_info.value_count);
+    size_t first = 0;
+    if (delta)
+    {
+        const auto unchanged = (static_cast<int64_t>(since_value_count.value()) - sensor_detail_info.start) / sensor_detail_info.values_per_point;
+        first = std::clamp<int64_t>(unchanged, 0, sensor_detail_info.history.size());
+    }
 
-    auto stats_json = json_document.createNestedObject("stats");
+    esp32::chunked_response response(request, json_media_type, etag);
+    std::array<char, 96> header;
+    const auto length = snprintf(header.data(), header.size(), "{\"cursor\":\"%s\",\"delta\":%s,\"start\":%lld,\"step\":%lu,", cursor.c_str(),
+                                 delta ? "true" : "false", sensor_detail_info.start + static_cast<int64_t>(first * sensor_detail_info.values_per_point),
+                                 sensor_detail_info.values_per_point);
+    response.write({header.data(), static_cast<size_t>(length)});
+    write_sensor_history_json(response, sensor_detail_info, points, first);
+    response.write("}");
+    response.finish();
+}
 
-    if (sensor_detail_info.stat.has_value())
+void web_server::handle_sensor_bulk_history(esp32::http_request &request)
+{
+    ESP_LOGD(WEBSERVER_TAG, "api/sensor/history/bulk");
+    if (!check_authenticated(request))
     {
-        auto &&stats = sensor_detail_info.stat.value();
-        stats_json["max"].set(stats.max);
-        stats_json["min"].set(stats.min);
-        stats_json["mean"].set(stats.mean);
+        return;
+    }
+
+    const auto arguments = request.get_url_arguments({"ids", "range", "points"});
+    auto &&ids_arg = arguments[0];
+    auto &&range_arg = arguments[1];
+    auto &&points_arg = arguments[2];
+
+    // comma separated, all sensors if not supplied
+    std::bitset<total_sensors> ids;
+    if (ids_arg.has_value())
+    {
+        std::string_view ids_str = ids_arg.value();
+        while (!ids_str.empty())
+        {
+            const auto separator = ids_str.find(',');
+            const auto id = esp32::string::parse_number<uint8_t>(ids_str.substr(0, separator));
+            if (!id.has_value() || (id.value() >= total_sensors))
+            {
+                log_and_send_error(request, HTTPD_400_BAD_REQUEST, "sensor ids invalid");
+                return;
+            }
+            ids.set(id.value());
+            ids_str = (separator == std::string_view::npos) ? std::string_view{} : ids_str.substr(separator + 1);
+        }
     }
     else
     {
-        stats_json["max"].set(nullptr);
-        stats_json["min"].set(nullptr);
-        stats_json["mean"].set(nullptr);
+        ids.set();
     }
 
-    json_document["history"].set(sensor_detail_info.history);
+    const auto range_arg_num = range_arg.has_value() ? esp32::string::parse_number<uint32_t>(range_arg.value()) : std::nullopt;
+    if (range_arg.has_value() && (!range_arg_num.has_value() || (range_arg_num.value() == 0)))
+    {
+        log_and_send_error(request, HTTPD_400_BAD_REQUEST, "history range invalid");
+        return;
+    }
 
-    send_json_response(request, json_document);
+    const auto points_arg_num = points_arg.has_value() ? esp32::string::parse_number<uint16_t>(points_arg.value()) : std::nullopt;
+    if (points_arg.has_value() &&
+        (!points_arg_num.has_value() || (points_arg_num.value() == 0) || (points_arg_num.value() > sensor_history::default_max_points)))
+    {
+        log_and_send_error(request, HTTPD_400_BAD_REQUEST, "history points invalid");
+        return;
+    }
+
+    const auto range_seconds = range_arg_num.value_or(sensor_history::default_range_seconds);
+    const auto points = points_arg_num.value_or(sensor_history::default_max_points);
+
+    // one sensor in memory at a time, snapshots at the default size are shared with the single sensor requests
+    esp32::chunked_response response(request, json_media_type);
+    response.write("{\"sensors\":[");
+    bool first = true;
+    for (auto i = 0; i < total_sensors; i++)
+    {
+        if (!ids.test(i))
+        {
+            continue;
+        }
+
+        const auto id = static_cast<sensor_id_index>(i);
+        const auto snapshot = ui_interface_.get_sensor_detail_info(id, range_seconds);
+
+        std::array<char, 16> id_str;
+        const auto length = snprintf(id_str.data(), id_str.size(), "%s{\"id\":%d,", first ? "" : ",", i);
+        response.write({id_str.data(), static_cast<size_t>(length)});
+        write_sensor_history_json(response, *snapshot, points);
+        response.write("}");
+        first = false;
+    }
+    response.write("]}");
+    response.finish();
 }
 
 void web_server::handle_config_get(esp32::http_request &request)
@@ -382,11 +674,26 @@ void web_server::handle_other_settings_update(esp32::http_request &request)
         return;
     }
 
-    const auto arguments = request.get_form_url_encoded_arguments({"hostName", "autoScreenBrightness", "screenBrightness", "useFahrenheit"});
+    const auto arguments =
+        request.get_form_url_encoded_arguments({"hostName", "autoScreenBrightness", "screenBrightness", "useFahrenheit", "sps30SamplePeriod"});
     auto &&host_name = arguments[0];
     auto &&auto_screen_brightness = arguments[1];
     auto &&screen_brightness = arguments[2];
     auto &&use_fahrenheit = arguments[3];
+    auto &&sps30_sample_period = arguments[4];
+
+    // 0 measures continuously, otherwise a window of warm up and burst has to fit into the period
+    const auto is_valid_sps30_sample_period = [](uint16_t seconds) {
+        return (seconds == 0) ||
+               ((seconds >= sps30_sensor_device::min_sample_period_ms / 1000) && (seconds <= sps30_sensor_device::max_sample_period_ms / 1000));
+    };
+    const auto sps30_sample_period_num =
+        sps30_sample_period.has_value() ? esp32::string::parse_number<uint16_t>(sps30_sample_period.value()) : std::nullopt;
+    if (sps30_sample_period.has_value() && (!sps30_sample_period_num.has_value() || !is_valid_sps30_sample_period(sps30_sample_period_num.value())))
+    {
+        log_and_send_error(request, HTTPD_400_BAD_REQUEST, "sps30 sample period invalid");
+        return;
+    }
 
     if (host_name.has_value())
     {
@@ -405,6 +712,11 @@ void web_server::handle_other_settings_update(esp32::http_request &request)
 
     config_.set_use_fahrenheit(use_fahrenheit.has_value());
 
+    if (sps30_sample_period_num.has_value())
+    {
+        config_.set_sps30_sample_period_seconds(sps30_sample_period_num.value());
+    }
+
     config_.save();
 
     redirect_to_root(request);
@@ -511,37 +823,47 @@ void web_server::handle_firmware_upload(esp32::http_request &request)
     operations::instance.reboot();
 }
 
-void web_server::notify_sensor_change(sensor_id_index id)
+void web_server::notify_sensor_change(const sensor_values_change &changes)
 {
     try
     {
         if (events.connection_count())
         {
-            queue_work<web_server, sensor_id_index, &web_server::send_sensor_data>(id);
+            queue_work<web_server, sensor_values_change, &web_server::send_sensor_data>(changes);
         }
     }
     catch (const std::exception &ex)
     {
-        ESP_LOGW(WEBSERVER_TAG, "Failed to queue http event for %s with %s", get_sensor_name(id).data(), ex.what());
+        ESP_LOGW(WEBSERVER_TAG, "Failed to queue http event for sensors with %s", ex.what());
     }
 }
 
-void web_server::send_sensor_data(sensor_id_index id)
+void web_server::send_sensor_data(sensor_values_change changes)
 {
-    ESP_LOGD(WEBSERVER_TAG, "Sending sensor info for %.*s", get_sensor_name(id).size(), get_sensor_name(id).data());
-    const auto &sensor = ui_interface_.get_sensor(id);
-    const auto value = sensor.get_value();
+    ESP_LOGD(WEBSERVER_TAG, "Sending sensor info for 0x%lx", changes.changed);
 
-    BasicJsonDocument<esp32::psram::json_allocator> json_document(128);
+    BasicJsonDocument<esp32::psram::json_allocator> json_document(JSON_ARRAY_SIZE(total_sensors) + total_sensors * JSON_OBJECT_SIZE(3));
+    auto array = json_document.to<JsonArray>();
 
-    auto &&definition = get_sensor_definition(id);
-    json_document["value"] = value;
-    json_document["id"] = static_cast<uint8_t>(id);
-    json_document["level"] = static_cast<uint64_t>(definition.calculate_level(value));
+    // one frame for all the sensors of a read
+    for (auto i = 0; i < total_sensors; i++)
+    {
+        const auto id = static_cast<sensor_id_index>(i);
+        if (changes.has(id))
+        {
+            const auto value = changes.get(id);
+            auto &&definition = get_sensor_definition(id);
+
+            auto object = array.createNestedObject();
+            object["value"] = value;
+            object["id"] = i;
+            object["level"] = static_cast<uint64_t>(definition.calculate_level(value));
+        }
+    }
 
     esp32::psram::string json;
     serializeJson(json_document, json);
-    events.try_send(json.c_str(), "sensor", esp32::millis(), 0);
+    events.try_send(json.c_str(), "sensors", esp32::millis(), 0);
 }
 
 #ifdef CONFIG_ENABLE_SD_CARD_SUPPORT
@@ -579,13 +901,19 @@ void web_server::handle_dir_list(esp32::http_request &request)
         ESP_LOGD(WEBSERVER_TAG, "Done opendir for %s", path.c_str());
     }
 
-    BasicJsonDocument<esp32::psram::json_allocator> json_document(8196);
-    auto array = json_document.createNestedArray("data");
+    auto auto_close_dir = esp32::finally([&dir] { closedir(dir); });
+
+    // entries are streamed one at a time, so the listing size is not limited by a document
+    BasicJsonDocument<esp32::psram::json_allocator> json_document(1024);
+    esp32::chunked_response response(request, json_media_type);
+    response.write("{\"data\":[");
 
+    bool first = true;
     auto entry = readdir(dir);
     while (entry)
     {
-        auto nested_entry = array.createNestedObject();
+        json_document.clear();
+        auto nested_entry = json_document.to<JsonObject>();
         const auto full_path = path / entry->d_name;
         nested_entry["path"] = (std::filesystem::path("/") / full_path.lexically_relative(mount_path)).generic_string();
         nested_entry["isDir"] = entry->d_type == DT_DIR;
@@ -603,11 +931,15 @@ void web_server::handle_dir_list(esp32::http_request &request)
             nested_entry["size"] = entry->d_type == DT_DIR ? 0 : entry_stat.st_size;
             nested_entry["lastModified"] = entry_stat.st_mtim.tv_sec;
         }
+
+        response.write(first ? "" : ",");
+        serializeJson(json_document, response);
+        first = false;
         entry = readdir(dir);
     }
-    closedir(dir);
 
-    send_json_response(request, json_document);
+    response.write("]}");
+    response.finish();
 }
 
 void web_server::handle_fs_download(esp32::http_request &request)
@@ -858,11 +1190,14 @@ void web_server::handle_events(esp32::http_request &request)
 
     ESP_LOGI(WEBSERVER_TAG, "Events client first time");
 
-    // send all the events
+    // send all the values
+    sensor_values_change changes;
     for (auto i = 0; i < total_sensors; i++)
     {
-        notify_sensor_change(static_cast<sensor_id_index>(i));
+        const auto id = static_cast<sensor_id_index>(i);
+        changes.set(id, ui_interface_.get_sensor(id).get_value());
     }
+    notify_sensor_change(changes);
 }
 
 void web_server::handle_logging(esp32::http_request &request)
@@ -1083,7 +1418,7 @@ void web_server::on_run_command(esp32::http_request &request)
         return;
     }
 
-    run_command(command_arg.value());
+    run_command(ui_interface_, command_arg.value());
 
     send_empty_200(request);
 }
@@ -1115,6 +1450,33 @@ void web_server::send_table_response(esp32::http_request &request, ui_interface:
     send_json_response(request, json_document);
 }
 
+void web_server::handle_metrics(esp32::http_request &request)
+{
+    ESP_LOGD(WEBSERVER_TAG, "/metrics");
+    if (!check_authenticated(request))
+    {
+        return;
+    }
+
+    esp32::chunked_response response(request, metrics_media_type);
+    esp32::metrics::writer writer(response);
+    esp32::metrics::collector::collect_all(writer);
+    response.finish();
+}
+
+void web_server::collect(esp32::metrics::writer &writer) const
+{
+    esp32::http_server::collect(writer);
+
+    writer.family("http_event_source_clients", "Connected server sent event clients", esp32::metrics::metric_type::gauge);
+    writer.sample("http_event_source_clients", {{"stream", "events"}}, events.get_clients());
+    writer.sample("http_event_source_clients", {{"stream", "logs"}}, logging.get_clients());
+
+    writer.family("http_event_source_events_total", "Server sent events sent to the connected clients", esp32::metrics::metric_type::counter);
+    writer.sample("http_event_source_events_total", {{"stream", "events"}}, events.get_events_sent());
+    writer.sample("http_event_source_events_total", {{"stream", "logs"}}, logging.get_events_sent());
+}
+
 void web_server::send_json_response(esp32::http_request &request, const BasicJsonDocument<esp32::psram::json_allocator> &json_document)
 {
     if (json_document.overflowed())
@@ -1123,8 +1485,7 @@ void web_server::send_json_response(esp32::http_request &request, const BasicJso
         return;
     }
 
-    esp32::psram::string json;
-    json.reserve(json_document.memoryUsage() * 2);
-    serializeJson(json_document, json);
-    esp32::array_response::send_response(request, json, js_media_type);
+    esp32::chunked_response response(request, json_media_type);
+    serializeJson(json_document, response);
+    response.finish();
 }
\ No newline at end of file
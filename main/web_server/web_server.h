@@ -8,6 +8,7 @@
 #include "util/async_web_server/http_server.h"
 #include "util/default_event.h"
 #include "util/singleton.h"
+#include <esp_random.h>
 #include <vector>
 
 class config;
@@ -48,8 +49,11 @@ class web_server final : esp32::http_server, public esp32::singleton<web_server>
     // // ajax
     void handle_sensor_get(esp32::http_request &request);
     void handle_sensor_stats(esp32::http_request &request);
+    void handle_sensor_bulk_history(esp32::http_request &request);
     void handle_information_get(esp32::http_request &request);
+    void handle_sensor_device_stats_get(esp32::http_request &request);
     void handle_config_get(esp32::http_request &request);
+    void handle_metrics(esp32::http_request &request);
 
     // // helpers
     bool is_authenticated(esp32::http_request &request);
@@ -79,8 +83,8 @@ class web_server final : esp32::http_server, public esp32::singleton<web_server>
     static void send_empty_200(const esp32::http_request &request);
     static std::string get_file_sha256(const char *filename);
 
-    void notify_sensor_change(sensor_id_index id);
-    void send_sensor_data(sensor_id_index id);
+    void notify_sensor_change(const sensor_values_change &changes);
+    void send_sensor_data(sensor_values_change changes);
 
     void received_log_data(std::unique_ptr<std::string> log);
     void send_log_data(std::unique_ptr<std::string> log);
@@ -98,9 +102,13 @@ class web_server final : esp32::http_server, public esp32::singleton<web_server>
 
     void send_json_response(esp32::http_request &request, const BasicJsonDocument<esp32::psram::json_allocator> &document);
 
+    // adds the event source clients and events to the http server metrics
+    void collect(esp32::metrics::writer &writer) const override;
+
     esp32::event_source events;
+    const uint32_t history_epoch_{esp_random()}; // history cursors are only valid until reboot
     esp32::event_source logging;
 
-    esp32::default_event_subscriber_typed<sensor_id_index> instance_sensor_change_event_{
-        APP_COMMON_EVENT, SENSOR_VALUE_CHANGE, [this](esp_event_base_t, int32_t, sensor_id_index id) { notify_sensor_change(id); }};
+    esp32::default_event_subscriber_typed<sensor_values_change> instance_sensor_change_event_{
+        APP_COMMON_EVENT, SENSOR_VALUES_CHANGE, [this](esp_event_base_t, int32_t, sensor_values_change changes) { notify_sensor_change(changes); }};
 };
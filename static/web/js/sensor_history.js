@@ -0,0 +1,58 @@
+// Decodes /api/sensor/history/get?format=bin into the same shape as the json response,
+// see sensor_history_encoder.h for the layout
+function decodeSensorHistory(buffer) {
+    var view = new DataView(buffer);
+    if (view.getUint8(0) != 2) {
+        throw new Error("Unsupported sensor history version " + view.getUint8(0));
+    }
+
+    var flags = view.getUint8(1);
+    var count = view.getUint16(2, true);
+    var interval = view.getUint32(4, true);
+    var scale = view.getFloat32(8, true);
+    var decimals = Math.max(0, Math.round(-Math.log10(scale)));
+
+    // float precision, like the json response
+    function getFloat(offset, flag) {
+        return (flags & flag) ? Number(view.getFloat32(offset, true).toPrecision(7)) : null;
+    }
+
+    var history = [];
+    var quantized = 0;
+    var gap = false;
+    var position = 36;
+    while (history.length < count && position < view.byteLength) {
+        var token = 0;
+        var multiplier = 1;
+        var byte;
+        do {
+            byte = view.getUint8(position++);
+            token += (byte & 0x7F) * multiplier;
+            multiplier *= 128;
+        } while ((byte & 0x80) && position < view.byteLength);
+
+        var repeat = 1;
+        if (token == 1) {
+            gap = true;
+        } else if (token % 2) {
+            repeat = (token - 1) / 2;
+        } else {
+            var zigzag = token / 2;
+            quantized += (zigzag % 2) ? -(zigzag + 1) / 2 : zigzag / 2;
+            gap = false;
+        }
+
+        // gaps are null, like in the json response
+        var value = gap ? null : Number((quantized * scale).toFixed(decimals));
+        for (var i = 0; i < repeat && history.length < count; i++) {
+            history.push(value);
+        }
+    }
+
+    return {
+        stats: { min: getFloat(12, 1), max: getFloat(16, 1), mean: getFloat(20, 1) },
+        percentiles: { p50: getFloat(24, 2), p95: getFloat(28, 2), p99: getFloat(32, 2) },
+        history: history,
+        interval: interval
+    };
+}
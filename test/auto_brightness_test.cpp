@@ -0,0 +1,128 @@
+#include "hardware/display/auto_brightness.h"
+#include "test_check.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Brightness from lux against the log scale it stands for, 51 levels per decade of lux from 1 lux
+
+constexpr int hysteresis_levels = 8;
+
+static int expected_level(float lux)
+{
+    return std::clamp<int>(std::floor(std::log10(lux) * 51), 0, UINT8_MAX);
+}
+
+static void check_levels()
+{
+    CHECK(auto_brightness().get_brightness() == auto_brightness::default_brightness);
+
+    // the first value is taken as is, lux close to a level boundary is avoided as the table is in float
+    for (const float lux : {0.01f, 0.5f, 1.2f, 20.0f, 500.0f, 3000.0f, 45000.0f, 2e5f})
+    {
+        auto_brightness brightness;
+        brightness.add_lux(lux, 0);
+        if (brightness.get_brightness() != expected_level(lux))
+        {
+            std::fprintf(stderr, "%g lux: brightness %d, expected %d\n", lux, brightness.get_brightness(), expected_level(lux));
+        }
+        CHECK(brightness.get_brightness() == expected_level(lux));
+    }
+}
+
+static void check_hysteresis()
+{
+    auto_brightness brightness;
+    brightness.add_lux(500, 0);
+    CHECK(brightness.get_brightness() == 137);
+
+    // 20% more light is 4 levels, the backlight stays
+    uint32_t time = 0;
+    for (int i = 0; i < 60; i++)
+    {
+        brightness.add_lux(600, time += 1000);
+    }
+    CHECK(brightness.get_brightness() == 137);
+
+    // twice the light is 15 levels
+    for (int i = 0; i < 60; i++)
+    {
+        brightness.add_lux(1000, time += 1000);
+    }
+    CHECK(std::abs(brightness.get_brightness() - expected_level(1000)) <= hysteresis_levels);
+    CHECK(brightness.get_brightness() > 137 + hysteresis_levels);
+
+    // and back within the hysteresis of the new level does not move it
+    const auto level = brightness.get_brightness();
+    for (int i = 0; i < 60; i++)
+    {
+        brightness.add_lux(900, time += 1000);
+    }
+    CHECK(brightness.get_brightness() == level);
+}
+
+static void check_limits()
+{
+    // darkness and full light are reached even within the hysteresis
+    auto_brightness dark;
+    dark.add_lux(1.2f, 0);
+    CHECK(dark.get_brightness() == 4);
+    uint32_t time = 0;
+    for (int i = 0; i < 60; i++)
+    {
+        dark.add_lux(0.5f, time += 1000);
+    }
+    CHECK(dark.get_brightness() == 0);
+
+    auto_brightness bright;
+    bright.add_lux(80000, 0);
+    CHECK(bright.get_brightness() == expected_level(80000));
+    time = 0;
+    for (int i = 0; i < 60; i++)
+    {
+        bright.add_lux(150000, time += 1000);
+    }
+    CHECK(bright.get_brightness() == UINT8_MAX);
+}
+
+static void check_monotonic()
+{
+    // slowly brightening light never dims the backlight
+    auto_brightness brightness;
+    uint8_t previous = 0;
+    uint32_t time = 0;
+    for (float lux = 0.5f; lux < 2e5f; lux *= 1.01f)
+    {
+        brightness.add_lux(lux, time += 1000);
+        CHECK(brightness.get_brightness() >= previous);
+        previous = brightness.get_brightness();
+    }
+    CHECK(previous == UINT8_MAX);
+}
+
+static void check_read_rates()
+{
+    // 5 seconds after the light was switched on the backlight has followed as far when lux is read every
+    // second as when it is read every 5 seconds, 159 from 1351 lux of the average
+    for (const uint32_t interval : {1000u, 5000u})
+    {
+        auto_brightness brightness;
+        brightness.add_lux(20, 0);
+        CHECK(brightness.get_brightness() == 66);
+        for (uint32_t time = interval; time <= 5000; time += interval)
+        {
+            brightness.add_lux(2000, time);
+        }
+        CHECK(std::abs(brightness.get_brightness() - 159) <= hysteresis_levels);
+    }
+}
+
+int main()
+{
+    check_levels();
+    check_hysteresis();
+    check_limits();
+    check_monotonic();
+    check_read_rates();
+    return test_result("auto_brightness_test");
+}
@@ -0,0 +1,87 @@
+#include "util/circular_buffer.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Sum and copy of a full, wrapped buffer through operator[] (bounds check and wrap per element), the
+// iterators, as_spans() and copy_to(), for the raw history size and a power of two size.
+
+using clock_type = std::chrono::steady_clock;
+constexpr int rounds = 20000;
+
+template <class F> static double measure(size_t elements, F &&ftn)
+{
+    const auto start = clock_type::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        ftn();
+    }
+    return std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / (static_cast<double>(rounds) * elements);
+}
+
+template <size_t S> static void benchmark(const char *name)
+{
+    const auto buffer = std::make_unique<circular_buffer<float, S, uint16_t>>();
+    for (size_t i = 0; i < S + S / 3; i++)
+    {
+        buffer->push(static_cast<float>(i % 100));
+    }
+
+    volatile float sink = 0;
+    const auto indexed_sum = measure(S, [&] {
+        float sum = 0;
+        for (uint16_t i = 0; i < buffer->size(); i++)
+        {
+            sum += (*buffer)[i];
+        }
+        sink = sum;
+    });
+
+    const auto iterator_sum = measure(S, [&] {
+        float sum = 0;
+        for (const auto value : *buffer)
+        {
+            sum += value;
+        }
+        sink = sum;
+    });
+
+    const auto span_sum = measure(S, [&] {
+        float sum = 0;
+        const auto [first, second] = buffer->as_spans();
+        for (const auto value : first)
+        {
+            sum += value;
+        }
+        for (const auto value : second)
+        {
+            sum += value;
+        }
+        sink = sum;
+    });
+
+    std::vector<float> destination(S);
+    const auto indexed_copy = measure(S, [&] {
+        for (uint16_t i = 0; i < buffer->size(); i++)
+        {
+            destination[i] = (*buffer)[i];
+        }
+        sink = destination[S / 2];
+    });
+
+    const auto bulk_copy = measure(S, [&] {
+        buffer->copy_to(destination.data(), 0, buffer->size());
+        sink = destination[S / 2];
+    });
+
+    std::printf("%-24s sum ns/value: indexed %.3f, iterator %.3f, spans %.3f; copy ns/value: indexed %.3f, copy_to %.3f\n", name, indexed_sum,
+                iterator_sum, span_sum, indexed_copy, bulk_copy);
+}
+
+int main()
+{
+    benchmark<720>("720 (modulo)");
+    benchmark<1024>("1024 (power of two)");
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "test_check.h"
+#include "util/circular_buffer.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// The buffer against a std::deque doing the same operations, with a capacity which is a power of two
+// (mask indexing) and one which is not (modulo indexing)
+
+template <class B> static std::vector<int> from_spans(const B &buffer)
+{
+    const auto [first, second] = buffer.as_spans();
+    std::vector<int> values(first.begin(), first.end());
+    values.insert(values.end(), second.begin(), second.end());
+    return values;
+}
+
+template <size_t S, class IT = size_t> static void check_against_deque(std::mt19937 &random)
+{
+    const auto buffer = std::make_unique<circular_buffer<int, S, IT>>();
+    std::deque<int> expected;
+    std::uniform_int_distribution<int> operation(0, 9);
+
+    for (int i = 0; i < 20000; i++)
+    {
+        // mostly pushes so that the buffer is full and wraps most of the time
+        const auto choice = operation(random);
+        if (choice < 6)
+        {
+            CHECK(buffer->push(i) == (expected.size() < S));
+            expected.push_back(i);
+            if (expected.size() > S)
+            {
+                expected.pop_front();
+            }
+        }
+        else if (choice == 6)
+        {
+            CHECK(buffer->unshift(i) == (expected.size() < S));
+            expected.push_front(i);
+            if (expected.size() > S)
+            {
+                expected.pop_back();
+            }
+        }
+        else if (choice == 7 && !expected.empty())
+        {
+            CHECK(buffer->shift() == expected.front());
+            expected.pop_front();
+        }
+        else if (choice == 8 && !expected.empty())
+        {
+            CHECK(buffer->pop() == expected.back());
+            expected.pop_back();
+        }
+        else if (choice == 9 && i % 100 == 0)
+        {
+            buffer->clear();
+            expected.clear();
+        }
+
+        CHECK(buffer->size() == expected.size());
+        CHECK(buffer->available() == S - expected.size());
+        CHECK(buffer->is_full() == (expected.size() == S));
+        CHECK(buffer->isEmpty() == expected.empty());
+        if (expected.empty())
+        {
+            continue;
+        }
+
+        CHECK(buffer->first() == expected.front());
+        CHECK(buffer->last() == expected.back());
+        const IT index = i % expected.size();
+        CHECK((*buffer)[index] == expected[index]);
+
+        if (i % 7 == 0)
+        {
+            const std::vector<int> values(expected.begin(), expected.end());
+            CHECK(std::equal(buffer->begin(), buffer->end(), values.begin(), values.end()));
+            CHECK(from_spans(*buffer) == values);
+
+            std::vector<int> copy(S, -1);
+            const IT start = i % expected.size();
+            const IT count = S;
+            CHECK(buffer->copy_to(copy.data(), start, count) == expected.size() - start);
+            CHECK(std::equal(copy.begin(), copy.begin() + (expected.size() - start), values.begin() + start));
+            CHECK(expected.size() - start == S || copy[expected.size() - start] == -1);
+        }
+    }
+}
+
+static void check_spans()
+{
+    circular_buffer<int, 4> buffer;
+    CHECK(buffer.as_spans().first.empty() && buffer.as_spans().second.empty());
+
+    // the second span is only used while the contents wrap around the end of the storage
+    std::deque<int> expected;
+    bool wrapped = false;
+    for (int i = 0; i < 10; i++)
+    {
+        buffer.push(i);
+        expected.push_back(i);
+        if (expected.size() > 4)
+        {
+            expected.pop_front();
+        }
+
+        const auto [first, second] = buffer.as_spans();
+        CHECK(!first.empty());
+        CHECK(first.size() + second.size() == expected.size());
+        CHECK(from_spans(buffer) == std::vector<int>(expected.begin(), expected.end()));
+        wrapped |= !second.empty();
+    }
+    CHECK(wrapped);
+}
+
+static void check_copy_to()
+{
+    circular_buffer<float, 6> buffer;
+    float destination[6]{};
+    CHECK(buffer.copy_to(destination, 0, 6) == 0);
+
+    for (int i = 0; i < 9; i++)
+    {
+        buffer.push(i);
+    }
+
+    // a wrapped range takes two copies
+    CHECK(buffer.copy_to(destination, 1, 4) == 4);
+    CHECK(destination[0] == 4 && destination[1] == 5 && destination[2] == 6 && destination[3] == 7);
+    CHECK(buffer.copy_to(destination, 5, 4) == 1);
+    CHECK(destination[0] == 8);
+    CHECK(buffer.copy_to(destination, 6, 1) == 0);
+}
+
+static void check_iterators()
+{
+    circular_buffer<int, 5> buffer;
+    for (int i = 0; i < 8; i++)
+    {
+        buffer.push(i * 10);
+    }
+
+    auto begin = buffer.begin();
+    const auto end = buffer.end();
+    CHECK(end - begin == 5);
+    CHECK(*begin == 30 && begin[4] == 70 && *(end - 1) == 70);
+    CHECK(*(2 + begin) == 50);
+    CHECK(begin < end && !(end < begin));
+
+    auto iterator = begin;
+    CHECK(*iterator++ == 30 && *iterator == 40);
+    CHECK(*--iterator == 30);
+    iterator += 3;
+    CHECK(*iterator == 60);
+    iterator -= 2;
+    CHECK(*iterator == 40);
+
+    // random access lets the standard algorithms use it
+    CHECK(std::accumulate(begin, end, 0) == 30 + 40 + 50 + 60 + 70);
+    CHECK(std::lower_bound(begin, end, 55) - begin == 3);
+    CHECK(std::distance(std::make_reverse_iterator(end), std::make_reverse_iterator(begin)) == 5);
+    CHECK(*std::make_reverse_iterator(end) == 70);
+}
+
+int main()
+{
+    std::mt19937 random(1);
+    check_against_deque<8>(random);
+    check_against_deque<7>(random);
+    check_against_deque<1>(random);
+    check_against_deque<720, uint16_t>(random);
+    check_against_deque<250, uint8_t>(random);
+    check_spans();
+    check_copy_to();
+    check_iterators();
+    return test_result("circular_buffer_test");
+}
@@ -0,0 +1,47 @@
+#include "sensor_trace.h"
+#include "util/compressed_float_ring.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+// Encode and decode throughput and compression ratio of the full resolution history, per SPS30 channel.
+// Usage: compressed_float_ring_benchmark [trace.csv], a trace in the replay_sensor_device format
+
+int main(int argc, char **argv)
+{
+    using clock = std::chrono::steady_clock;
+    using ring_t = compressed_float_ring<256, 64>; // as in sensor_history
+    constexpr const char *names[] = {"pm 2.5", "pm 1", "pm 4", "pm 10", "typical size"};
+    constexpr float steps[] = {0.1f, 0.1f, 0.1f, 0.1f, 0.01f}; // value_step / 10
+
+    const auto trace = get_sensor_trace(argc, argv, 24 * 60 * 12, 5000);
+    if (trace.empty())
+    {
+        std::fprintf(stderr, "no trace rows\n");
+        return 1;
+    }
+
+    for (size_t channel = 0; channel < 5; channel++)
+    {
+        const auto ring = std::make_unique<ring_t>();
+        ring->set_quantization_step(steps[channel]);
+
+        const auto encode_start = clock::now();
+        for (auto &&row : trace)
+        {
+            ring->push(row.values[channel]);
+        }
+        const std::chrono::duration<double> encode_time = clock::now() - encode_start;
+
+        double sum = 0;
+        const auto decode_start = clock::now();
+        ring->for_each_newest(ring->size(), [&sum](float value) { sum += value; });
+        const std::chrono::duration<double> decode_time = clock::now() - decode_start;
+
+        const double raw_bytes = ring->size() * sizeof(float);
+        std::printf("%-13s %7zu values in %6zu bytes, %5.1fx, %4.1f hours; encode %6.1f M/s, decode %6.1f M/s (%g)\n", names[channel],
+                    ring->size(), ring->encoded_size(), raw_bytes / ring->encoded_size(), ring->size() * 5.0 / 3600,
+                    trace.size() / encode_time.count() / 1e6, ring->size() / decode_time.count() / 1e6, sum);
+    }
+    return 0;
+}
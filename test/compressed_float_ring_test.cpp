@@ -0,0 +1,222 @@
+#include "hardware/sensors/sensor_history.h"
+#include "test_check.h"
+#include "util/compressed_float_ring.h"
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+
+using ring_t = compressed_float_ring<64, 8>;
+
+static std::vector<float> newest(const ring_t &ring, size_t count)
+{
+    std::vector<float> values;
+    ring.for_each_newest(count, [&values](float value) { values.push_back(value); });
+    return values;
+}
+
+static void check_round_trip()
+{
+    // deltas of one and several varint bytes, negative values, runs and runs across blocks
+    ring_t ring;
+    ring.set_quantization_step(0.1f);
+    std::vector<float> expected;
+    std::mt19937 random(5);
+    std::uniform_int_distribution<int> step(-3, 3);
+    std::uniform_int_distribution<int> jump(0, 40);
+
+    int32_t quantized = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        quantized += (jump(random) == 0) ? 100000 * step(random) : step(random) * (i % 5 == 0 ? 0 : 1);
+        expected.push_back(quantized * 0.1f);
+        ring.push(expected.back());
+    }
+
+    CHECK(ring.size() <= expected.size());
+    const auto values = newest(ring, ring.size());
+    CHECK(values.size() == ring.size());
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        CHECK_NEAR(values[i], expected[expected.size() - values.size() + i], 1e-3);
+    }
+}
+
+static void check_newest_count()
+{
+    ring_t ring;
+    ring.set_quantization_step(1);
+    for (int i = 0; i < 50; i++)
+    {
+        ring.push(i);
+    }
+
+    CHECK(newest(ring, 0).empty());
+    const auto last = newest(ring, 10);
+    CHECK(last.size() == 10);
+    CHECK(last.front() == 40 && last.back() == 49);
+    CHECK(newest(ring, 1000).size() == 50);
+}
+
+static void check_runs()
+{
+    // a constant value is a single run token per block
+    ring_t ring;
+    ring.set_quantization_step(1);
+    for (int i = 0; i < 10000; i++)
+    {
+        ring.push(7);
+    }
+    CHECK(ring.size() == 10000);
+    CHECK(ring.encoded_size() <= 4);
+
+    const auto values = newest(ring, 10000);
+    CHECK(values.size() == 10000);
+    CHECK(std::all_of(values.begin(), values.end(), [](float value) { return value == 7; }));
+}
+
+static void check_drops_oldest_block()
+{
+    // once every block is used the oldest sealed one goes, the newest values stay exact
+    ring_t ring;
+    ring.set_quantization_step(1);
+    std::deque<float> expected;
+    for (int i = 0; i < 5000; i++)
+    {
+        const float value = (i * 7919) % 1000; // large deltas, about 2 bytes each
+        ring.push(value);
+        expected.push_back(value);
+    }
+
+    CHECK(ring.size() < expected.size());
+    CHECK(ring.encoded_size() <= ring_t::memory_size);
+    const auto values = newest(ring, ring.size());
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        CHECK(values[i] == expected[expected.size() - values.size() + i]);
+    }
+}
+
+static void check_save_load()
+{
+    ring_t ring;
+    ring.set_quantization_step(0.5f);
+    for (int i = 0; i < 400; i++)
+    {
+        ring.push((i % 37) * 0.5f);
+    }
+
+    std::vector<uint8_t> data;
+    esp32::binary_io::memory_writer writer(data);
+    CHECK(ring.save(writer));
+
+    ring_t loaded;
+    loaded.set_quantization_step(0.5f);
+    esp32::binary_io::memory_reader reader(data.data(), data.size());
+    CHECK(loaded.load(reader));
+    CHECK(reader.remaining() == 0);
+    CHECK(newest(loaded, loaded.size()) == newest(ring, ring.size()));
+
+    // another step would decode other values
+    ring_t other_step;
+    other_step.set_quantization_step(1);
+    esp32::binary_io::memory_reader other_reader(data.data(), data.size());
+    CHECK(!other_step.load(other_reader));
+    CHECK(other_step.size() == 0);
+
+    // a truncated save leaves the ring empty
+    ring_t truncated;
+    truncated.set_quantization_step(0.5f);
+    esp32::binary_io::memory_reader truncated_reader(data.data(), data.size() / 2);
+    CHECK(!truncated.load(truncated_reader));
+    CHECK(truncated.size() == 0);
+}
+
+static void check_gaps()
+{
+    // gaps decode as NaN wherever they fall, the value after a gap is still a delta of the one before it
+    ring_t ring;
+    ring.set_quantization_step(1);
+    ring.push(NAN);
+    ring.push(3);
+    ring.push(NAN, 4);
+    ring.push(3);
+    ring.push(5, 3);
+    ring.push(NAN, 100000);
+    ring.push(6);
+
+    const auto values = newest(ring, ring.size());
+    CHECK(ring.size() == 100011);
+    CHECK(values.size() == ring.size());
+    CHECK(std::isnan(values[0]) && values[1] == 3);
+    CHECK(std::all_of(values.begin() + 2, values.begin() + 6, [](float value) { return std::isnan(value); }));
+    CHECK(values[6] == 3 && values[7] == 5 && values[9] == 5);
+    CHECK(std::all_of(values.begin() + 10, values.end() - 1, [](float value) { return std::isnan(value); }));
+    CHECK(values.back() == 6);
+
+    // a long gap is a single run
+    CHECK(ring.encoded_size() < 16);
+
+    std::vector<uint8_t> data;
+    esp32::binary_io::memory_writer writer(data);
+    CHECK(ring.save(writer));
+    ring_t loaded;
+    loaded.set_quantization_step(1);
+    esp32::binary_io::memory_reader reader(data.data(), data.size());
+    CHECK(loaded.load(reader));
+    loaded.push(NAN);
+    loaded.push(6);
+    const auto loaded_values = newest(loaded, 3);
+    CHECK(loaded_values[0] == 6 && std::isnan(loaded_values[1]) && loaded_values[2] == 6);
+}
+
+static void check_history_full_resolution()
+{
+    // more than the raw hour at full resolution comes from the ring
+    const auto history = std::make_unique<sensor_history>();
+    history->set_value_step(1);
+    std::vector<float> expected;
+    for (int i = 0; i < 3 * 720; i++)
+    {
+        expected.push_back((i / 3) % 50);
+        history->add_value(expected.back());
+    }
+
+    const auto snapshot = history->get_snapshot(3 * 60 * 60, sensor_history::max_full_resolution_points);
+    CHECK(snapshot.interval_seconds == 5);
+    CHECK(snapshot.history.size() == expected.size());
+    for (size_t i = 0; i < snapshot.history.size(); i++)
+    {
+        CHECK_NEAR(snapshot.history[i], expected[i], 1e-4);
+    }
+    CHECK(snapshot.start == 0);
+
+    // the default points keep the minute tier
+    const auto default_snapshot = history->get_snapshot(3 * 60 * 60, sensor_history::default_max_points);
+    CHECK(default_snapshot.interval_seconds == 60);
+    CHECK(default_snapshot.history.size() == 180);
+
+    // after a boot the ring has less than the range, as much as the minute tier
+    const auto short_history = std::make_unique<sensor_history>();
+    short_history->set_value_step(1);
+    for (int i = 0; i < 30; i++)
+    {
+        short_history->add_value(i);
+    }
+    const auto short_snapshot = short_history->get_snapshot(12 * 60 * 60, sensor_history::max_full_resolution_points);
+    CHECK(short_snapshot.interval_seconds == 5);
+    CHECK(short_snapshot.history.size() == 30);
+}
+
+int main()
+{
+    check_round_trip();
+    check_newest_count();
+    check_runs();
+    check_drops_oldest_block();
+    check_save_load();
+    check_gaps();
+    check_history_full_resolution();
+    return test_result("compressed_float_ring_test");
+}
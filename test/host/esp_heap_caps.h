@@ -0,0 +1,32 @@
+#pragma once
+
+// Host build: all capabilities map to the C heap
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline void *heap_caps_malloc(size_t size, uint32_t)
+{
+    return malloc(size);
+}
+
+inline void *heap_caps_calloc(size_t count, size_t size, uint32_t)
+{
+    return calloc(count, size);
+}
+
+inline void *heap_caps_realloc(void *pointer, size_t size, uint32_t)
+{
+    return realloc(pointer, size);
+}
+
+inline void heap_caps_free(void *pointer)
+{
+    free(pointer);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Host build: the few FreeRTOS definitions the tested utilities use, on top of the C++ standard library
+
+#include <cassert>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY UINT32_MAX
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) (ms)
+#define configASSERT(x) assert(x)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <mutex>
+
+typedef struct
+{
+    std::timed_mutex mutex;
+} StaticSemaphore_t;
+
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    return buffer;
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t)
+{
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+    {
+        handle->mutex.lock();
+        return pdTRUE;
+    }
+    return handle->mutex.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+    handle->mutex.unlock();
+    return pdTRUE;
+}
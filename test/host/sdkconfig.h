@@ -0,0 +1,5 @@
+#pragma once
+
+// Host build of the sensor headers, with a CO2 sensor so that its filter chain is covered
+
+#define CONFIG_SCD4x_SENSOR_ENABLE 1
@@ -0,0 +1,176 @@
+#include "hardware/sensors/sensor_history.h"
+#include "sensor_trace.h"
+#include "test_check.h"
+#include "util/p_square_quantile.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+// P² estimates against the exact quantiles of the same values. The error is measured as rank, the fraction
+// of values below the estimate, which does not depend on the scale of the values.
+
+static double rank_of(const std::vector<float> &sorted, float value)
+{
+    const auto below = std::lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+    const auto not_above = std::upper_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+    return (below + not_above) / 2.0 / sorted.size();
+}
+
+static void check_estimates(const char *name, const std::vector<float> &values)
+{
+    constexpr float quantiles[] = {0.5f, 0.95f, 0.99f};
+    constexpr double rank_tolerance[] = {0.02, 0.01, 0.005};
+
+    std::vector<float> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+
+    for (size_t i = 0; i < std::size(quantiles); i++)
+    {
+        p_square_quantile estimator(quantiles[i]);
+        for (const auto value : values)
+        {
+            estimator.add(value);
+        }
+
+        const auto estimate = estimator.get();
+        CHECK(estimate.has_value());
+        CHECK(estimator.count() == values.size());
+        CHECK(estimate.value() >= sorted.front() && estimate.value() <= sorted.back());
+
+        const auto rank = rank_of(sorted, estimate.value());
+        if (std::fabs(rank - quantiles[i]) > rank_tolerance[i])
+        {
+            std::fprintf(stderr, "%s: p%g estimate %g has rank %g\n", name, quantiles[i] * 100, estimate.value(), rank);
+        }
+        CHECK_NEAR(rank, quantiles[i], rank_tolerance[i]);
+    }
+}
+
+static std::vector<float> generate(size_t count, const std::function<float()> &next)
+{
+    std::vector<float> values(count);
+    std::generate(values.begin(), values.end(), next);
+    return values;
+}
+
+static void check_distributions()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> uniform(0, 100);
+    std::normal_distribution<float> normal(50, 10);
+    std::lognormal_distribution<float> lognormal(2, 0.8f); // particulate matter is skewed like this
+    std::exponential_distribution<float> exponential(0.1f);
+
+    check_estimates("uniform", generate(20000, [&] { return uniform(random); }));
+    check_estimates("normal", generate(20000, [&] { return normal(random); }));
+    check_estimates("lognormal", generate(50000, [&] { return lognormal(random); }));
+    check_estimates("exponential", generate(50000, [&] { return exponential(random); }));
+
+    // sorted input moves every marker on each value
+    int next = 0;
+    check_estimates("ascending", generate(10000, [&] { return static_cast<float>(next++); }));
+    check_estimates("descending", generate(10000, [&] { return static_cast<float>(next--); }));
+}
+
+static void check_trace()
+{
+    // a day of pm 2.5 at 5 second reads. Values are whole numbers with many ties, where the rank jumps,
+    // so the estimates are compared by value: within the rounding for p50, within 5% for the tail.
+    std::vector<float> trace;
+    for (auto &&row : generate_sensor_trace(24 * 60 * 12, 5000, 3))
+    {
+        trace.push_back(row.values[0]);
+    }
+
+    std::vector<float> sorted(trace);
+    std::sort(sorted.begin(), sorted.end());
+    const auto exact = [&sorted](float quantile) { return sorted[std::lround(quantile * (sorted.size() - 1))]; };
+
+    p_square_quantile p50(0.5f);
+    p_square_quantile p95(0.95f);
+    p_square_quantile p99(0.99f);
+    for (const auto value : trace)
+    {
+        p50.add(value);
+        p95.add(value);
+        p99.add(value);
+    }
+
+    CHECK_NEAR(p50.get().value(), exact(0.5f), 1.5);
+    CHECK_NEAR(p95.get().value(), exact(0.95f), exact(0.95f) * 0.05);
+    CHECK_NEAR(p99.get().value(), exact(0.99f), exact(0.99f) * 0.05);
+}
+
+static void check_few_values()
+{
+    // exact until the markers are initialized
+    p_square_quantile median(0.5f);
+    CHECK(!median.get().has_value());
+    median.add(3);
+    CHECK(median.get() == 3);
+    median.add(1);
+    median.add(2);
+    CHECK(median.get() == 2);
+
+    p_square_quantile p95(0.95f);
+    p95.add(5);
+    p95.add(-1);
+    p95.add(7);
+    CHECK(p95.get() == 7);
+
+    median.clear();
+    CHECK(!median.get().has_value());
+    CHECK(median.count() == 0);
+}
+
+static void check_constant()
+{
+    p_square_quantile estimator(0.99f);
+    for (int i = 0; i < 1000; i++)
+    {
+        estimator.add(12.5f);
+    }
+    CHECK(estimator.get() == 12.5f);
+}
+
+static void check_history_window()
+{
+    // two generations restarted half a window apart, the reported one forgets values older than a window
+    const auto percentiles = std::make_unique<sensor_history_percentiles_t<1000>>();
+    CHECK(!percentiles->get().has_value());
+
+    for (int i = 0; i < 1000; i++)
+    {
+        percentiles->add_value(10);
+    }
+    CHECK(percentiles->get()->p50 == 10);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        percentiles->add_value(100);
+    }
+    const auto value = percentiles->get();
+    CHECK(value->p50 == 100 && value->p95 == 100 && value->p99 == 100);
+
+    // half way through the next window the older values still count
+    for (int i = 0; i < 400; i++)
+    {
+        percentiles->add_value(i % 2 ? 0 : 200);
+    }
+    CHECK(percentiles->get()->p50 == 100);
+
+    percentiles->clear();
+    CHECK(!percentiles->get().has_value());
+}
+
+int main()
+{
+    check_distributions();
+    check_trace();
+    check_few_values();
+    check_constant();
+    check_history_window();
+    return test_result("p_square_quantile_test");
+}
@@ -0,0 +1,223 @@
+#include "hardware/sensors/sensor_history.h"
+#include "test_check.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <random>
+
+// The running sum and monotonic min/max queues against a rescan of the same window
+
+template <uint16_t countT> static void check_window_against_rescan(std::mt19937 &random, size_t values)
+{
+    const auto window = std::make_unique<sensor_value_window_t<countT>>();
+    std::deque<float> expected;
+    std::normal_distribution<float> noise(0, 3);
+    std::uniform_int_distribution<int> spike(0, 50);
+
+    float level = 20;
+    for (size_t i = 0; i < values; i++)
+    {
+        // a slow random walk with spikes and runs of equal values, rounded like the sensors round
+        level += noise(random) / 10;
+        const float value = std::round((spike(random) == 0 ? level * 5 : level) * 10) / 10;
+        window->add_value(value);
+        expected.push_back(value);
+        if (expected.size() > countT)
+        {
+            expected.pop_front();
+        }
+
+        const auto stats = window->get_stats();
+        CHECK(stats.has_value());
+        if (!stats.has_value())
+        {
+            return;
+        }
+
+        const auto [min, max] = std::minmax_element(expected.begin(), expected.end());
+        const double mean = std::accumulate(expected.begin(), expected.end(), 0.0) / expected.size();
+        CHECK(stats->min == *min);
+        CHECK(stats->max == *max);
+        CHECK_NEAR(stats->mean, mean, 1e-3);
+        CHECK(window->size() == expected.size());
+    }
+}
+
+static void check_empty()
+{
+    sensor_value_window_t<16> window;
+    CHECK(!window.get_stats().has_value());
+    CHECK(!window.get_average().has_value());
+
+    window.add_value(1);
+    window.clear();
+    CHECK(!window.get_stats().has_value());
+}
+
+static void check_monotonic_sequences()
+{
+    // the candidate queues are longest for sorted input
+    sensor_value_window_t<8> increasing;
+    sensor_value_window_t<8> decreasing;
+    for (int i = 0; i < 100; i++)
+    {
+        increasing.add_value(i);
+        decreasing.add_value(-i);
+        if (i >= 7)
+        {
+            CHECK(increasing.get_stats()->min == i - 7);
+            CHECK(increasing.get_stats()->max == i);
+            CHECK(decreasing.get_stats()->min == -i);
+            CHECK(decreasing.get_stats()->max == -(i - 7));
+        }
+    }
+}
+
+static void check_sequence_wrap()
+{
+    // the window numbers values with a 16 bit sequence, run well past its wrap
+    std::mt19937 random(7);
+    check_window_against_rescan<720>(random, 70000);
+}
+
+static void check_history_stats()
+{
+    // the tiered history reports the stats of its raw hour
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> values(0, 1000);
+
+    const auto history = std::make_unique<sensor_history>();
+    std::deque<float> expected;
+    for (int i = 0; i < 2000; i++)
+    {
+        const auto value = std::round(values(random));
+        history->add_value(value);
+        expected.push_back(value);
+        if (expected.size() > 720)
+        {
+            expected.pop_front();
+        }
+    }
+
+    const auto stats = history->get_stats();
+    CHECK(stats.has_value());
+    const auto [min, max] = std::minmax_element(expected.begin(), expected.end());
+    CHECK(stats->min == *min);
+    CHECK(stats->max == *max);
+    CHECK_NEAR(stats->mean, std::accumulate(expected.begin(), expected.end(), 0.0) / expected.size(), 1e-2);
+    CHECK_NEAR(history->get_average().value(), stats->mean, 1e-6);
+}
+
+static void check_window_gaps()
+{
+    // gaps take a place in the window but are left out of the stats
+    sensor_value_window_t<4> window;
+    window.add_value(NAN);
+    CHECK(!window.get_stats().has_value());
+    window.add_value(2);
+    window.add_value(NAN);
+    window.add_value(4);
+    CHECK(window.get_stats()->min == 2 && window.get_stats()->max == 4);
+    CHECK_NEAR(window.get_stats()->mean, 3, 1e-6);
+
+    window.add_value(NAN);
+    window.add_value(NAN);
+    CHECK(window.size() == 4);
+    CHECK(window.get_stats()->min == 4 && window.get_stats()->max == 4);
+    window.add_value(NAN);
+    window.add_value(NAN);
+    CHECK(!window.get_stats().has_value());
+    window.add_value(1);
+    CHECK(window.get_stats()->min == 1 && window.get_stats()->max == 1);
+}
+
+static void check_history_gap()
+{
+    // a gap moves every tier forward, its points are NaN and a bucket it completes keeps its values
+    const auto history = std::make_unique<sensor_history>();
+    history->set_value_step(1);
+    for (int i = 0; i < 6; i++)
+    {
+        history->add_value(10);
+    }
+    history->add_gap(12 * 60 * 3);
+    history->add_value(20);
+
+    const auto raw = history->get_snapshot(60 * 60, 720);
+    CHECK(raw.interval_seconds == 5);
+    CHECK(raw.value_count == 6 + 12 * 60 * 3 + 1);
+    CHECK(raw.history.size() == 720);
+    CHECK(std::all_of(raw.history.begin(), raw.history.end() - 1, [](float value) { return std::isnan(value); }));
+    CHECK(raw.history.back() == 20);
+    CHECK(raw.stat->min == 20 && raw.stat->max == 20);
+
+    const auto minutes = history->get_snapshot(4 * 60 * 60, 240);
+    CHECK(minutes.interval_seconds == 60);
+    CHECK(minutes.history.size() == 181);
+    CHECK(minutes.history.front() == 10);
+    CHECK(std::isnan(minutes.history[1]) && std::isnan(minutes.history[179]));
+    CHECK(minutes.history.back() == 20);
+    CHECK(minutes.stat->min == 10 && minutes.stat->max == 20);
+    CHECK(minutes.start == 0);
+
+    const auto full_resolution = history->get_snapshot(4 * 60 * 60, sensor_history::max_full_resolution_points);
+    CHECK(full_resolution.interval_seconds == 5);
+    CHECK(full_resolution.history.size() == raw.value_count);
+    CHECK(full_resolution.history.front() == 10 && std::isnan(full_resolution.history[6]) && full_resolution.history.back() == 20);
+
+    // a gap longer than the history leaves only gaps
+    history->add_gap(100 * 24 * 60 * 12);
+    CHECK(!history->get_stats().has_value());
+    CHECK(!history->get_snapshot(90 * 24 * 60 * 60, sensor_history::default_max_points).stat.has_value());
+}
+
+static void check_history_save()
+{
+    // a copy saved to memory loads back to the same snapshots
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> values(0, 500);
+    const auto history = std::make_unique<sensor_history>();
+    history->set_value_step(1);
+    for (int i = 0; i < 5000; i++)
+    {
+        history->add_value(values(random));
+    }
+    history->add_gap(100);
+    history->add_value(1);
+
+    std::vector<uint8_t> data{1, 2};
+    const auto write_count = history->save(data);
+    CHECK(write_count == history->write_count());
+    CHECK(data[0] == 1 && data[1] == 2);
+
+    const auto loaded = std::make_unique<sensor_history>();
+    loaded->set_value_step(1);
+    esp32::binary_io::memory_reader reader(data.data() + 2, data.size() - 2);
+    CHECK(loaded->load(reader));
+    CHECK(reader.remaining() == 0);
+    for (const auto range : {60 * 60, 6 * 60 * 60, 7 * 24 * 60 * 60})
+    {
+        const auto expected = history->get_snapshot(range, sensor_history::default_max_points).history;
+        const auto actual = loaded->get_snapshot(range, sensor_history::default_max_points).history;
+        CHECK(expected.size() == actual.size());
+        CHECK(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end(),
+                         [](float a, float b) { return a == b || (std::isnan(a) && std::isnan(b)); }));
+    }
+}
+
+int main()
+{
+    std::mt19937 random(1);
+    check_empty();
+    check_monotonic_sequences();
+    check_window_against_rescan<1>(random, 100);
+    check_window_against_rescan<5>(random, 1000);
+    check_window_against_rescan<720>(random, 5000);
+    check_sequence_wrap();
+    check_history_stats();
+    check_window_gaps();
+    check_history_gap();
+    check_history_save();
+    return test_result("sensor_history_stats_test");
+}
@@ -0,0 +1,238 @@
+#include "hardware/sensors/sensor_filter.h"
+#include "hardware/sensors/sensor_history.h"
+#include "sensor_trace.h"
+#include "test_check.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+// An SPS30 trace through the filters and the history the way the sensor task runs them: every read is
+// filtered, the latest filtered value goes into the history once per history interval.
+// The checks run on a generated trace, the throughput is printed for it or for a trace given as argument.
+
+using clock_type = std::chrono::steady_clock;
+
+// trace columns in the order of sensor_trace_row::values
+constexpr std::array<sensor_id_index, 5> trace_sensors{sensor_id_index::pm_2_5, sensor_id_index::pm_1, sensor_id_index::pm_4, sensor_id_index::pm_10,
+                                                       sensor_id_index::typical_particle_size};
+
+struct pipeline
+{
+    sensor_filters filters;
+    std::unique_ptr<std::array<sensor_history, trace_sensors.size()>> histories = std::make_unique<std::array<sensor_history, trace_sensors.size()>>();
+    std::array<float, trace_sensors.size()> latest{};
+    std::array<std::vector<float>, trace_sensors.size()> added; // values added to each history
+    uint32_t next_history_time{sensor_history::sensor_interval};
+
+    pipeline()
+    {
+        for (size_t i = 0; i < trace_sensors.size(); i++)
+        {
+            (*histories)[i].set_value_step(i == 4 ? 0.1f : 1);
+        }
+    }
+
+    void read(const sensor_trace_row &row, bool keep_added)
+    {
+        while (static_cast<int32_t>(row.time - next_history_time) >= 0)
+        {
+            for (size_t i = 0; i < trace_sensors.size(); i++)
+            {
+                (*histories)[i].add_value(latest[i]);
+                if (keep_added)
+                {
+                    added[i].push_back(latest[i]);
+                }
+            }
+            next_history_time += sensor_history::sensor_interval;
+        }
+
+        for (size_t i = 0; i < trace_sensors.size(); i++)
+        {
+            latest[i] = filters.apply(trace_sensors[i], row.values[i], row.time);
+        }
+    }
+};
+
+static std::vector<float> filter_column(const std::vector<sensor_trace_row> &rows, size_t column)
+{
+    sensor_filters filters;
+    std::vector<float> filtered;
+    filtered.reserve(rows.size());
+    for (auto &&row : rows)
+    {
+        filtered.push_back(filters.apply(trace_sensors[column], row.values[column], row.time));
+    }
+    return filtered;
+}
+
+static void check_particle_filters()
+{
+    // single read spikes are rejected, the filtered values follow the trace otherwise. Spikes are added where
+    // the trace is steady, next to a step the median picks the step either way.
+    const auto clean = generate_sensor_trace(6 * 60 * 60, 1000, 5);
+    auto spiked = clean;
+    size_t spikes = 0;
+    for (size_t i = 50; i < spiked.size(); i += 500)
+    {
+        const auto [low, high] = std::minmax({clean[i - 1].values[0], clean[i + 1].values[0], clean[i + 2].values[0]});
+        if (high - low <= 2)
+        {
+            spiked[i].values[0] = spiked[i].values[0] * 20 + 100;
+            spikes++;
+        }
+    }
+    CHECK(spikes > 30);
+
+    const auto filtered_clean = filter_column(clean, 0);
+    const auto filtered_spiked = filter_column(spiked, 0);
+
+    double error = 0;
+    float max_spike_error = 0;
+    for (size_t i = 0; i < clean.size(); i++)
+    {
+        error += std::fabs(filtered_clean[i] - clean[i].values[0]);
+        max_spike_error = std::max(max_spike_error, std::fabs(filtered_spiked[i] - filtered_clean[i]));
+        CHECK(filtered_clean[i] == std::round(filtered_clean[i]));
+    }
+    std::printf("pm 2.5: mean error %.3f, max error from spikes %.1f\n", error / clean.size(), max_spike_error);
+    CHECK(error / clean.size() < 1.0);
+    CHECK(max_spike_error <= 2);
+
+    // the particle size keeps its decimal
+    const auto filtered_size = filter_column(clean, 4);
+    CHECK(std::all_of(filtered_size.begin(), filtered_size.end(), [](float value) { return std::fabs(value * 10 - std::round(value * 10)) < 1e-3; }));
+}
+
+static void check_invalid_values()
+{
+    // NaN is passed through and restarts the chain, the next value is not averaged with older ones
+    sensor_filters filters;
+    uint32_t time = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        filters.apply(sensor_id_index::pm_2_5, 100, time += filter_interval_ms);
+    }
+    CHECK(std::isnan(filters.apply(sensor_id_index::pm_2_5, NAN, time += filter_interval_ms)));
+    CHECK(filters.apply(sensor_id_index::pm_2_5, 10, time += filter_interval_ms) == 10);
+
+    // chains are per sensor
+    CHECK(filters.apply(sensor_id_index::pm_10, 30, time) == 30);
+    CHECK(filters.apply(sensor_id_index::pm_2_5, 12, time += filter_interval_ms) == 10); // lower median of two
+    CHECK(filters.apply(sensor_id_index::pm_2_5, 12, time += filter_interval_ms) == 11);
+}
+
+static void check_co2_rate_limit()
+{
+    // a step is followed at the rate limit, a single breath is rejected by the median
+    constexpr uint32_t interval = 30 * 1000;
+    sensor_filters filters;
+    uint32_t time = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        CHECK(filters.apply(sensor_id_index::CO2, 450, time += interval) == 450);
+    }
+    CHECK(filters.apply(sensor_id_index::CO2, 5000, time += interval) == 450);
+
+    float previous = 450;
+    for (int i = 0; i < 30; i++)
+    {
+        const auto value = filters.apply(sensor_id_index::CO2, 1000, time += interval);
+        CHECK(value - previous <= 100);
+        CHECK(value <= 1000);
+        previous = value;
+    }
+    CHECK(previous == 1000);
+}
+
+template <class F> static float step_response(uint32_t read_interval, uint32_t duration, float from, float to)
+{
+    F filter;
+    filter(from, 0);
+    float value = from;
+    for (uint32_t time = read_interval; time <= duration; time += read_interval)
+    {
+        value = filter(to, time);
+    }
+    return value;
+}
+
+static void check_read_rates()
+{
+    // after the same time a step has moved as far whether the device was read every second or less often
+    using ema = ema_filter<50, 5000>;
+    CHECK_NEAR(step_response<ema>(5000, 20000, 0, 16), 15, 1e-4);
+    CHECK_NEAR(step_response<ema>(1000, 20000, 0, 16), 15, 1e-4);
+    CHECK_NEAR(step_response<ema>(20000, 20000, 0, 16), 15, 1e-4);
+
+    using rate_limit = rate_limit_filter<100, 30000>;
+    CHECK_NEAR(step_response<rate_limit>(30000, 60000, 450, 1000), 650, 1e-3);
+    CHECK_NEAR(step_response<rate_limit>(1000, 60000, 450, 1000), 650, 1e-2);
+    CHECK_NEAR(step_response<rate_limit>(6000, 60000, 450, 1000), 650, 1e-3);
+}
+
+static void check_history()
+{
+    // 26 hours of reads, ending on a complete minute of the history
+    const auto trace = generate_sensor_trace(26 * 60 * 60 + 1, 1000, 9);
+    pipeline pipe;
+    for (auto &&row : trace)
+    {
+        pipe.read(row, true);
+    }
+
+    for (size_t i = 0; i < trace_sensors.size(); i++)
+    {
+        const auto &history = (*pipe.histories)[i];
+        const auto &added = pipe.added[i];
+
+        // the last hour is kept as added
+        const auto hour = history.get_snapshot(60 * 60, 720);
+        CHECK(hour.values_per_point == 1);
+        CHECK(hour.history.size() == 720);
+        CHECK(std::equal(hour.history.begin(), hour.history.end(), added.end() - 720));
+
+        const auto stats = history.get_stats();
+        const auto [hour_min, hour_max] = std::minmax_element(added.end() - 720, added.end());
+        CHECK(stats->min == *hour_min && stats->max == *hour_max);
+        CHECK_NEAR(stats->mean, std::accumulate(added.end() - 720, added.end(), 0.0) / 720, 1e-3);
+
+        // a day is rolled up to minutes without changing its stats
+        const uint32_t day_values = 24 * 60 * 12;
+        const auto day = history.get_snapshot(24 * 60 * 60, 24 * 60);
+        CHECK(day.values_per_point == 12);
+        CHECK(day.history.size() == 24 * 60);
+        CHECK(added.size() % 12 == 0);
+        CHECK(day.start == static_cast<int64_t>(added.size() - day_values));
+        const auto [day_min, day_max] = std::minmax_element(added.end() - day_values, added.end());
+        CHECK(day.stat->min == *day_min && day.stat->max == *day_max);
+        CHECK_NEAR(day.stat->mean, std::accumulate(added.end() - day_values, added.end(), 0.0) / day_values, 1e-2);
+    }
+}
+
+static void measure_throughput(const std::vector<sensor_trace_row> &trace)
+{
+    pipeline pipe;
+    const auto start = clock_type::now();
+    for (auto &&row : trace)
+    {
+        pipe.read(row, false);
+    }
+    const auto seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    const auto samples = trace.size() * trace_sensors.size();
+    std::printf("pipeline: %zu samples in %.3f s, %.0f samples/s, %.0f ns/sample\n", samples, seconds, samples / seconds, seconds * 1e9 / samples);
+}
+
+int main(int argc, char **argv)
+{
+    check_particle_filters();
+    check_invalid_values();
+    check_co2_rate_limit();
+    check_read_rates();
+    check_history();
+    measure_throughput(get_sensor_trace(argc, argv, 2 * 24 * 60 * 60, 1000));
+    return test_result("sensor_pipeline_test");
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * SPS30 style trace for the benchmarks: rows of time in ms and pm 2.5, pm 1, pm 4, pm 10, typical particle size,
+ * the CSV format of replay_sensor_device. Either loaded from a recorded file or generated: a slow drift with
+ * sensor noise and an occasional cooking spike which decays over minutes, rounded like the device values.
+ */
+struct sensor_trace_row
+{
+    uint32_t time;
+    std::array<float, 5> values;
+};
+
+inline std::vector<sensor_trace_row> load_sensor_trace(const char *path)
+{
+    std::vector<sensor_trace_row> rows;
+    FILE *file = std::fopen(path, "r");
+    if (!file)
+    {
+        return rows;
+    }
+
+    char line[128];
+    while (std::fgets(line, sizeof(line), file))
+    {
+        char *end;
+        const auto time = std::strtoul(line, &end, 10);
+        if (end == line)
+        {
+            continue;
+        }
+
+        sensor_trace_row row{static_cast<uint32_t>(time), {}};
+        for (auto &&value : row.values)
+        {
+            char *value_start = (*end == ',') ? end + 1 : end;
+            value = std::strtof(value_start, &end);
+            if (end == value_start)
+            {
+                value = NAN;
+            }
+        }
+        rows.push_back(row);
+    }
+    std::fclose(file);
+    return rows;
+}
+
+inline std::vector<sensor_trace_row> generate_sensor_trace(size_t count, uint32_t interval_ms, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::normal_distribution<float> drift(0, 0.05f);
+    std::normal_distribution<float> noise(0, 0.4f);
+    std::uniform_int_distribution<int> spike_chance(0, 4000);
+
+    std::vector<sensor_trace_row> rows;
+    rows.reserve(count);
+    float level = 8;
+    float spike = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        level = std::clamp(level + drift(random), 1.0f, 40.0f);
+        spike = (spike_chance(random) == 0) ? 150 : spike * 0.995f;
+
+        const float pm_2_5 = std::max(0.0f, std::round(level + spike + noise(random)));
+        const float pm_1 = std::round(pm_2_5 * 0.9f);
+        const float pm_4 = std::round(pm_2_5 * 1.05f);
+        const float pm_10 = std::round(pm_2_5 * 1.1f);
+        const float size = std::round((0.6f + noise(random) / 20) * 10) / 10;
+        rows.push_back({static_cast<uint32_t>(i * interval_ms), {pm_2_5, pm_1, pm_4, pm_10, size}});
+    }
+    return rows;
+}
+
+/**
+ * The trace given as first argument, or a generated one of `count` rows
+ */
+inline std::vector<sensor_trace_row> get_sensor_trace(int argc, char **argv, size_t count, uint32_t interval_ms)
+{
+    if (argc > 1)
+    {
+        auto rows = load_sensor_trace(argv[1]);
+        std::printf("trace %s: %zu rows\n", argv[1], rows.size());
+        return rows;
+    }
+    std::printf("generated trace: %zu rows\n", count);
+    return generate_sensor_trace(count, interval_ms, 42);
+}
@@ -0,0 +1,156 @@
+#include "hardware/sensors/sensor_history.h"
+#include "test_check.h"
+#include "util/seqlock.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Readers racing a single writer never see a torn copy, and the writer is never held up by them.
+// Writer latencies are printed, they are not checked as they depend on the machine.
+
+using clock_type = std::chrono::steady_clock;
+constexpr size_t reader_count = 3;
+
+struct writer_latency
+{
+    double total_ns{0};
+    double max_ns{0};
+    size_t writes{0};
+
+    void add(clock_type::duration duration)
+    {
+        const double ns = std::chrono::duration<double, std::nano>(duration).count();
+        total_ns += ns;
+        max_ns = std::max(max_ns, ns);
+        writes++;
+    }
+
+    void print(const char *name) const
+    {
+        std::printf("%s: %zu writes, mean %.0f ns, max %.0f ns\n", name, writes, total_ns / writes, max_ns);
+    }
+};
+
+static void check_seqlock()
+{
+    // every field is written with the same value, a torn read has two different ones
+    esp32::seqlock lock;
+    std::array<uint32_t, 64> data{};
+    std::atomic_bool done{false};
+    std::atomic_size_t torn{0};
+    std::atomic_size_t reads{0};
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < reader_count; i++)
+    {
+        readers.emplace_back([&] {
+            uint32_t previous = 0;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                const auto copy = lock.read([&] { return data; });
+                if (!std::all_of(copy.begin(), copy.end(), [&copy](uint32_t value) { return value == copy[0]; }) || copy[0] < previous)
+                {
+                    torn++;
+                }
+                previous = copy[0];
+                reads++;
+            }
+        });
+    }
+
+    writer_latency latency;
+    for (uint32_t value = 1; value <= 200000; value++)
+    {
+        const auto start = clock_type::now();
+        {
+            std::lock_guard<esp32::seqlock> guard(lock);
+            data.fill(value);
+        }
+        latency.add(clock_type::now() - start);
+    }
+    done = true;
+    for (auto &&reader : readers)
+    {
+        reader.join();
+    }
+
+    CHECK(torn == 0);
+    CHECK(reads > 0);
+    CHECK(lock.sequence() == 2 * 200000);
+    latency.print("seqlock");
+    std::printf("seqlock: %zu reads by %zu readers\n", reads.load(), reader_count);
+}
+
+static void check_history_snapshots()
+{
+    // value n is added as the n-th value, so a consistent raw snapshot is consecutive and ends at value_count - 1
+    const auto history = std::make_unique<sensor_history>();
+    history->set_value_step(1);
+    std::atomic_bool done{false};
+    std::atomic_size_t inconsistent{0};
+    std::atomic_size_t snapshots{0};
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < reader_count; i++)
+    {
+        readers.emplace_back([&, i] {
+            // readers ask for different tiers, like the detail screen and web clients do
+            const uint32_t range = (i == 0) ? 60 * 60 : (i == 1) ? 2 * 60 * 60 : 24 * 60 * 60;
+            const uint16_t points = (i == 1) ? sensor_history::max_full_resolution_points : 720;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                const auto snapshot = history->get_shared_snapshot(range, points);
+                const auto &values = snapshot->history;
+                // values pending in a finer tier than the one shown are less than a point
+                const auto covered = snapshot->start + static_cast<int64_t>(values.size() * snapshot->values_per_point);
+                bool consistent =
+                    (covered <= snapshot->value_count + snapshot->values_per_point) && (covered + snapshot->values_per_point > snapshot->value_count);
+                if (snapshot->values_per_point == 1 && !values.empty())
+                {
+                    consistent &= values.back() == snapshot->value_count - 1;
+                    for (size_t j = 1; j < values.size(); j++)
+                    {
+                        consistent &= values[j] == values[j - 1] + 1;
+                    }
+                }
+                else
+                {
+                    consistent &= std::is_sorted(values.begin(), values.end());
+                }
+                inconsistent += !consistent;
+                snapshots++;
+            }
+        });
+    }
+
+    writer_latency latency;
+    for (uint32_t value = 0; value < 100000; value++)
+    {
+        const auto start = clock_type::now();
+        history->add_value(value);
+        latency.add(clock_type::now() - start);
+    }
+    done = true;
+    for (auto &&reader : readers)
+    {
+        reader.join();
+    }
+
+    CHECK(inconsistent == 0);
+    CHECK(snapshots > 0);
+    latency.print("sensor_history add_value");
+    std::printf("sensor_history: %zu snapshots by %zu readers\n", snapshots.load(), reader_count);
+}
+
+int main()
+{
+    check_seqlock();
+    check_history_snapshots();
+    return test_result("seqlock_stress_test");
+}
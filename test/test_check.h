@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the host tests, a failed check is reported and fails the test at exit
+
+inline int test_failures = 0;
+
+#define CHECK(condition_)                                                                                                                            \
+    do                                                                                                                                               \
+    {                                                                                                                                                \
+        if (!(condition_))                                                                                                                           \
+        {                                                                                                                                            \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition_);                                                     \
+            test_failures++;                                                                                                                         \
+        }                                                                                                                                            \
+    } while (false)
+
+#define CHECK_NEAR(actual_, expected_, tolerance_)                                                                                                   \
+    do                                                                                                                                               \
+    {                                                                                                                                                \
+        const double actual_value_ = (actual_);                                                                                                      \
+        const double expected_value_ = (expected_);                                                                                                  \
+        if (!(std::fabs(actual_value_ - expected_value_) <= (tolerance_)))                                                                           \
+        {                                                                                                                                            \
+            std::fprintf(stderr, "%s:%d: check failed: %s = %.9g, expected %.9g\n", __FILE__, __LINE__, #actual_, actual_value_, expected_value_); \
+            test_failures++;                                                                                                                         \
+        }                                                                                                                                            \
+    } while (false)
+
+inline int test_result(const char *name)
+{
+    if (test_failures)
+    {
+        std::fprintf(stderr, "%s: %d checks failed\n", name, test_failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("%s: passed\n", name);
+    return EXIT_SUCCESS;
+}